@@ -32,7 +32,7 @@
 
 #include "client/cl_types.h"
 
-#define CGAME_API_VERSION 20
+#define CGAME_API_VERSION 21
 
 /**
  * @brief The client game import struct imports engine functionailty to the client game.
@@ -121,12 +121,28 @@ typedef struct cg_import_s {
 	void (*FreeTag)(mem_tag_t tag);
 
 	/**
-	 * @brief Creates and starts a thread for the given function.
-	 * @param name The thread name.
-	 * @param run The thread function.
+	 * @brief Submits a job to the thread pool.
+	 * @param run The job function.
 	 * @param data User data.
+	 * @param counter An optional counter to wait on with `WaitCounter`.
 	 */
-	thread_t *(*Thread)(const char *name, ThreadRunFunc run, void *data);
+	void (*Submit)(ThreadRunFunc run, void *data, thread_counter_t *counter);
+
+	/**
+	 * @brief Runs the given function over `[0, count)` in ranges of `grain` indices,
+	 * returning when all ranges have completed.
+	 * @param count The number of indices.
+	 * @param grain The number of indices per job.
+	 * @param run The range function.
+	 * @param data User data.
+	 */
+	void (*ParallelFor)(size_t count, size_t grain, ThreadRangeFunc run, void *data);
+
+	/**
+	 * @brief Waits for all jobs submitted with the given counter to complete.
+	 * @param counter The counter.
+	 */
+	void (*WaitCounter)(thread_counter_t *counter);
 
 	/**
 	 * @}
@@ -165,7 +165,9 @@ void Cl_InitCgame(void) {
 	import.Free = Mem_Free;
 	import.FreeTag = Mem_FreeTag;
 
-	import.Thread = Thread_Create_;
+	import.Submit = Thread_Submit;
+	import.ParallelFor = Thread_ParallelFor;
+	import.WaitCounter = Thread_WaitCounter;
 
 	import.BaseDir = Fs_BaseDir;
 	import.OpenFile = Fs_OpenRead;
@@ -31,9 +31,9 @@ static void Cl_ParsePlayerState(const cl_frame_t *delta_frame, cl_frame_t *frame
 	static player_state_t null_state;
 
 	if (delta_frame && delta_frame->valid) {
-		Net_ReadDeltaPlayerState(&net_message, &delta_frame->ps, &frame->ps);
+		Net_ReadDeltaPlayerState(&net_message, &delta_frame->ps, &frame->ps, cl.protocol);
 	} else {
-		Net_ReadDeltaPlayerState(&net_message, &null_state, &frame->ps);
+		Net_ReadDeltaPlayerState(&net_message, &null_state, &frame->ps, cl.protocol);
 	}
 
 	if (cl.demo_server) { // if playing a demo, force freeze
@@ -85,7 +85,7 @@ static void Cl_ReadDeltaEntity(cl_frame_t *frame, const entity_state_t *from, ui
 
 	frame->num_entities++;
 
-	Net_ReadDeltaEntity(&net_message, from, to, number, bits);
+	Net_ReadDeltaEntity(&net_message, from, to, number, bits, cl.protocol);
 
 	// check to see if the delta was successful and valid
 	if (!Cl_ValidDeltaEntity(frame, ent, from, to)) {
@@ -163,7 +163,7 @@ static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
 		}
 
 		// now deal with the new entity
-		const uint16_t bits = Net_ReadShort(&net_message);
+		const uint16_t bits = Net_ReadDeltaEntityBits(&net_message, cl.protocol);
 
 		if (bits & U_REMOVE) { // remove it, no delta
 
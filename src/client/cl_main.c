@@ -608,6 +608,8 @@ void Cl_Frame(const uint32_t msec) {
 		}
 	}
 
+	Mem_ResetArena(cls.frame_arena);
+
 	Cl_AttemptConnect();
 
 	Cl_HttpThink();
@@ -656,6 +658,8 @@ void Cl_Init(void) {
 
 	cls.state = CL_DISCONNECTED;
 
+	cls.frame_arena = Mem_CreateArena(CL_FRAME_ARENA_SIZE, MEM_TAG_CLIENT);
+
 	Cl_InitConsole();
 
 	Cl_InitLocal();
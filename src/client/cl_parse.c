@@ -142,11 +142,11 @@ static void Cl_ParseBaseline(void) {
 	static entity_state_t null_state;
 
 	const uint16_t number = Net_ReadShort(&net_message);
-	const uint16_t bits = Net_ReadShort(&net_message);
+	const uint16_t bits = Net_ReadDeltaEntityBits(&net_message, cl.protocol);
 
 	cl_entity_t *ent = &cl.entities[number];
 
-	Net_ReadDeltaEntity(&net_message, &null_state, &ent->baseline, number, bits);
+	Net_ReadDeltaEntity(&net_message, &null_state, &ent->baseline, number, bits, cl.protocol);
 
 	// initialize clipping matrices
 	if (ent->baseline.solid) {
@@ -275,11 +275,13 @@ static void Cl_ParseServerData(void) {
 	const uint16_t major = Net_ReadShort(&net_message);
 	const uint16_t minor = Net_ReadShort(&net_message);
 
-	// ensure protocol major matches
-	if (major != PROTOCOL_MAJOR) {
+	// ensure protocol major is supported, as demos may be recorded with an older one
+	if (major != PROTOCOL_MAJOR && major != PROTOCOL_MAJOR_LEGACY) {
 		Com_Error(ERROR_DROP, "Server is using protocol major %d, you have %d\n", major, PROTOCOL_MAJOR);
 	}
 
+	cl.protocol = major;
+
 	// determine if we're viewing a demo
 	cl.demo_server = Net_ReadByte(&net_message);
 
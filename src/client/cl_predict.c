@@ -23,9 +23,11 @@
 
 /**
  * @brief Prepares the collision model to clip to the specified entity. For
- * mesh models, the box hull must be set to reflect the bounds of the entity.
+ * mesh models, the box hull is initialized to reflect the bounds of the entity.
+ *
+ * @return The head node of the entity's inline BSP model, or -1 for the box hull.
  */
-static int32_t Cl_HullForEntity(const entity_state_t *s) {
+static int32_t Cl_HullForEntity(const entity_state_t *s, cm_box_hull_t *hull) {
 
 	if (s->solid == SOLID_BSP) {
 		const cm_bsp_model_t *mod = cl.cm_models[s->model1];
@@ -40,10 +42,12 @@ static int32_t Cl_HullForEntity(const entity_state_t *s) {
 	const cl_entity_t *ent = &cl.entities[s->number];
 
 	if (s->client) {
-		return Cm_SetBoxHull(ent->mins, ent->maxs, CONTENTS_MONSTER);
+		Cm_InitBoxHull(hull, ent->mins, ent->maxs, CONTENTS_MONSTER);
 	} else {
-		return Cm_SetBoxHull(ent->mins, ent->maxs, CONTENTS_SOLID);
+		Cm_InitBoxHull(hull, ent->mins, ent->maxs, CONTENTS_SOLID);
 	}
+
+	return -1;
 }
 
 /**
@@ -69,9 +73,10 @@ int32_t Cl_PointContents(const vec3_t point) {
 			continue;
 		}
 
-		const int32_t head_node = Cl_HullForEntity(s);
+		cm_box_hull_t hull;
+		const int32_t head_node = Cl_HullForEntity(s, &hull);
 
-		contents |= Cm_TransformedPointContents(point, head_node, &ent->inverse_matrix);
+		contents |= Cm_TransformedPointContents(point, head_node, &hull, &ent->inverse_matrix);
 	}
 
 	return contents;
@@ -117,10 +122,12 @@ static void Cl_ClipTraceToEntities(cl_trace_t *trace) {
 			continue;
 		}
 
-		const int32_t head_node = Cl_HullForEntity(s);
+		cm_box_hull_t hull;
+		const int32_t head_node = Cl_HullForEntity(s, &hull);
 
 		cm_trace_t tr = Cm_TransformedBoxTrace(trace->start, trace->end, trace->mins, trace->maxs,
-		                                       head_node, trace->contents, &ent->matrix, &ent->inverse_matrix);
+		                                       head_node, &hull, trace->contents, &ent->matrix,
+		                                       &ent->inverse_matrix);
 
 		if (tr.start_solid || tr.fraction < trace->trace.fraction) {
 			trace->trace = tr;
@@ -202,15 +209,25 @@ void Cl_PredictMovement(void) {
 		return;
 	}
 
-	GList *cmds = NULL;
+	GList *cmds = NULL, *cmd = NULL;
 
+	// the list is built in the frame arena, and released with it
 	while (++ack <= last) {
-		cmds = g_list_append(cmds, &cl.cmds[ack & CMD_MASK]);
+		GList *e = Mem_ArenaMalloc(cls.frame_arena, sizeof(GList));
+
+		e->data = &cl.cmds[ack & CMD_MASK];
+		e->prev = cmd;
+
+		if (cmd) {
+			cmd->next = e;
+		} else {
+			cmds = e;
+		}
+
+		cmd = e;
 	}
 
 	cls.cgame->PredictMovement(cmds);
-
-	g_list_free(cmds);
 }
 
 /**
@@ -190,6 +190,7 @@ typedef struct {
 	// tracked view angles to account for spawn and teleport direction changes
 	vec3_t angles;
 
+	int32_t protocol; // the PROTOCOL_MAJOR of the server or demo, for net message encoding
 	_Bool demo_server; // we're viewing a demo
 	_Bool third_person; // we're viewing third person camera
 
@@ -320,6 +321,11 @@ typedef enum {
 	NOTIFICATION_SERVER_PARSED
 } cl_notification_t;
 
+/**
+ * @brief The chunk size of the client frame arena.
+ */
+#define CL_FRAME_ARENA_SIZE 4096
+
 /**
  * @brief The cl_static_t structure is persistent for the execution of the
  * game. It is only cleared when Cl_Init is called. It is not exposed to the
@@ -355,6 +361,8 @@ typedef struct {
 
 	uint32_t broadcast_time; // time when last broadcast ping was sent
 
+	mem_arena_t *frame_arena; // transient allocations, reset each frame
+
 	struct cg_export_s *cgame;
 } cl_static_t;
 
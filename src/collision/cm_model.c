@@ -32,8 +32,8 @@ static void Cm_LoadBspPlanes(void) {
 	const int32_t num_planes = cm_bsp.bsp.num_planes;
 	const bsp_plane_t *in = cm_bsp.bsp.planes;
 
-	cm_bsp_plane_t *out = cm_bsp.planes = Mem_TagMalloc(sizeof(cm_bsp_plane_t) * (num_planes + 12),
-	                                      MEM_TAG_CMODEL); // extra for box hull
+	cm_bsp_plane_t *out = cm_bsp.planes = Mem_TagMalloc(sizeof(cm_bsp_plane_t) * num_planes,
+	                                      MEM_TAG_CMODEL);
 
 	for (int32_t i = 0; i < num_planes; i++, in++, out++) {
 
@@ -56,8 +56,8 @@ static void Cm_LoadBspNodes(void) {
 	const int32_t num_nodes = cm_bsp.bsp.num_nodes;
 	const bsp_node_t *in = cm_bsp.bsp.nodes;
 
-	cm_bsp_node_t *out = cm_bsp.nodes = Mem_TagMalloc(sizeof(cm_bsp_node_t) * (num_nodes + 6),
-	                                    MEM_TAG_CMODEL); // extra for box hull
+	cm_bsp_node_t *out = cm_bsp.nodes = Mem_TagMalloc(sizeof(cm_bsp_node_t) * num_nodes,
+	                                    MEM_TAG_CMODEL);
 
 	for (int32_t i = 0; i < num_nodes; i++, in++, out++) {
 
@@ -69,6 +69,28 @@ static void Cm_LoadBspNodes(void) {
 	}
 }
 
+/**
+ * @brief Packs the nodes for traversal, inlining their planes.
+ */
+static void Cm_PackBspNodes(void) {
+
+	const int32_t num_nodes = cm_bsp.bsp.num_nodes;
+	const cm_bsp_node_t *in = cm_bsp.nodes;
+
+	cm_bsp_packed_node_t *out = cm_bsp.packed_nodes = Mem_TagMalloc(sizeof(cm_bsp_packed_node_t) * num_nodes,
+	                            MEM_TAG_CMODEL);
+
+	for (int32_t i = 0; i < num_nodes; i++, in++, out++) {
+
+		VectorCopy(in->plane->normal, out->normal);
+		out->dist = in->plane->dist;
+		out->type = in->plane->type;
+
+		out->children[0] = in->children[0];
+		out->children[1] = in->children[1];
+	}
+}
+
 /**
  * @brief
  */
@@ -105,8 +127,8 @@ static void Cm_LoadBspLeafs(void) {
 	const int32_t num_leafs = cm_bsp.bsp.num_leafs;
 	const bsp_leaf_t *in = cm_bsp.bsp.leafs;
 
-	cm_bsp_leaf_t *out = cm_bsp.leafs = Mem_TagMalloc(sizeof(cm_bsp_leaf_t) * (num_leafs + 1),
-	                                    MEM_TAG_CMODEL); // extra for box hull
+	cm_bsp_leaf_t *out = cm_bsp.leafs = Mem_TagMalloc(sizeof(cm_bsp_leaf_t) * num_leafs,
+	                                    MEM_TAG_CMODEL);
 
 	for (int32_t i = 0; i < num_leafs; i++, in++, out++) {
 
@@ -130,8 +152,8 @@ static void Cm_LoadBspLeafBrushes(void) {
 	const int32_t num_leaf_brushes = cm_bsp.bsp.num_leaf_brushes;
 	const uint16_t *in = cm_bsp.bsp.leaf_brushes;
 
-	uint16_t *out = cm_bsp.leaf_brushes = Mem_TagMalloc(sizeof(uint16_t) * (num_leaf_brushes + 1),
-	                                      MEM_TAG_CMODEL); // extra for box hull
+	uint16_t *out = cm_bsp.leaf_brushes = Mem_TagMalloc(sizeof(uint16_t) * num_leaf_brushes,
+	                                      MEM_TAG_CMODEL);
 
 	for (int32_t i = 0; i < num_leaf_brushes; i++, in++, out++) {
 
@@ -169,8 +191,8 @@ static void Cm_LoadBspBrushes(void) {
 	const int32_t num_brushes = cm_bsp.bsp.num_brushes;
 	const bsp_brush_t *in = cm_bsp.bsp.brushes;
 
-	cm_bsp_brush_t *out = cm_bsp.brushes = Mem_TagMalloc(sizeof(cm_bsp_brush_t) * (num_brushes + 1),
-	                                       MEM_TAG_CMODEL); // extra for box hull
+	cm_bsp_brush_t *out = cm_bsp.brushes = Mem_TagMalloc(sizeof(cm_bsp_brush_t) * num_brushes,
+	                                       MEM_TAG_CMODEL);
 
 	for (int32_t i = 0; i < num_brushes; i++, in++, out++) {
 
@@ -190,8 +212,8 @@ static void Cm_LoadBspBrushSides(void) {
 	const int32_t num_brush_sides = cm_bsp.bsp.num_brush_sides;
 	const bsp_brush_side_t *in = cm_bsp.bsp.brush_sides;
 
-	cm_bsp_brush_side_t *out = cm_bsp.brush_sides = Mem_TagMalloc(sizeof(cm_bsp_brush_side_t) * (num_brush_sides + 6),
-	                           MEM_TAG_CMODEL); // extra for box hull
+	cm_bsp_brush_side_t *out = cm_bsp.brush_sides = Mem_TagMalloc(sizeof(cm_bsp_brush_side_t) * num_brush_sides,
+	                           MEM_TAG_CMODEL);
 
 	for (int32_t i = 0; i < num_brush_sides; i++, in++, out++) {
 
@@ -219,7 +241,7 @@ static void Cm_LoadBspBrushSides(void) {
 }
 
 /**
- * @brief Sets brush bounds for fast trace tests.
+ * @brief Sets brush bounds, and lays them out per leaf, for fast trace tests.
  */
 static void Cm_SetupBspBrushes(void) {
 	cm_bsp_brush_t *b = cm_bsp.brushes;
@@ -235,6 +257,23 @@ static void Cm_SetupBspBrushes(void) {
 		b->maxs[1] = bs[3].plane->dist;
 		b->maxs[2] = bs[5].plane->dist;
 	}
+
+	const int32_t num_leaf_brushes = cm_bsp.bsp.num_leaf_brushes;
+
+	cm_bsp_leaf_brush_t *out = cm_bsp.leaf_brush_bounds = Mem_TagMalloc(sizeof(cm_bsp_leaf_brush_t) * num_leaf_brushes,
+	                           MEM_TAG_CMODEL);
+
+	for (int32_t i = 0; i < num_leaf_brushes; i++, out++) {
+		const int32_t brush_num = cm_bsp.leaf_brushes[i];
+
+		b = cm_bsp.brushes + brush_num;
+
+		VectorCopy(b->mins, out->mins);
+		VectorCopy(b->maxs, out->maxs);
+
+		out->contents = b->contents;
+		out->brush_num = brush_num;
+	}
 }
 
 /**
@@ -363,9 +402,11 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 	Mem_Free(cm_bsp.materials);
 	Mem_Free(cm_bsp.planes);
 	Mem_Free(cm_bsp.nodes);
+	Mem_Free(cm_bsp.packed_nodes);
 	Mem_Free(cm_bsp.texinfos);
 	Mem_Free(cm_bsp.leafs);
 	Mem_Free(cm_bsp.leaf_brushes);
+	Mem_Free(cm_bsp.leaf_brush_bounds);
 	Mem_Free(cm_bsp.models);
 	Mem_Free(cm_bsp.brushes);
 	Mem_Free(cm_bsp.brush_sides);
@@ -428,7 +469,7 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 
 	Cm_SetupBspBrushes();
 
-	Cm_InitBoxHull();
+	Cm_PackBspNodes();
 
 	Cm_FloodAreas();
 
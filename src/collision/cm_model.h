@@ -44,9 +44,11 @@ typedef struct {
 
 	cm_bsp_plane_t *planes;
 	cm_bsp_node_t *nodes;
+	cm_bsp_packed_node_t *packed_nodes;
 	cm_bsp_texinfo_t *texinfos;
 	cm_bsp_leaf_t *leafs;
 	uint16_t *leaf_brushes;
+	cm_bsp_leaf_brush_t *leaf_brush_bounds;
 	cm_bsp_model_t *models;
 	cm_bsp_brush_t *brushes;
 	cm_bsp_brush_side_t *brush_sides;
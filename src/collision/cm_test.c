@@ -119,132 +119,54 @@ int32_t Cm_BoxOnPlaneSide(const vec3_t mins, const vec3_t maxs, const cm_bsp_pla
 }
 
 /**
- * @brief Bounding box to BSP tree structure for box positional testing.
+ * @brief Initializes the box hull for the specified bounds. The box hull is a
+ * single brush, with one side per axial plane of the bounds.
  */
-typedef struct {
-	int32_t head_node;
-	cm_bsp_plane_t *planes;
-	cm_bsp_brush_t *brush;
-	cm_bsp_leaf_t *leaf;
-} cm_box_t;
-
-static cm_box_t cm_box;
-
-/**
- * @brief Appends a brush (6 nodes, 12 planes) opaquely to the primary BSP
- * structure to represent the bounding box used for Cm_BoxLeafnums. This brush
- * is never tested by the rest of the collision detection code, as it resides
- * just beyond the parsed size of the map.
- */
-void Cm_InitBoxHull(void) {
+void Cm_InitBoxHull(cm_box_hull_t *hull, const vec3_t mins, const vec3_t maxs, const int32_t contents) {
 	static cm_bsp_texinfo_t null_surface;
 
-	if (cm_bsp.bsp.num_planes + 12 > MAX_BSP_PLANES) {
-		Com_Error(ERROR_DROP, "MAX_BSP_PLANES\n");
-	}
-
-	if (cm_bsp.bsp.num_nodes + 6 > MAX_BSP_NODES) {
-		Com_Error(ERROR_DROP, "MAX_BSP_NODES\n");
-	}
-
-	if (cm_bsp.bsp.num_leafs + 1 > MAX_BSP_LEAFS) {
-		Com_Error(ERROR_DROP, "MAX_BSP_LEAFS\n");
-	}
-
-	if (cm_bsp.bsp.num_leaf_brushes + 1 > MAX_BSP_LEAF_BRUSHES) {
-		Com_Error(ERROR_DROP, "MAX_BSP_LEAF_BRUSHES\n");
-	}
-
-	if (cm_bsp.bsp.num_brushes + 1 > MAX_BSP_BRUSHES) {
-		Com_Error(ERROR_DROP, "MAX_BSP_BRUSHES\n");
-	}
-
-	if (cm_bsp.bsp.num_brush_sides + 6 > MAX_BSP_BRUSH_SIDES) {
-		Com_Error(ERROR_DROP, "MAX_BSP_BRUSH_SIDES\n");
-	}
-
-	// head node
-	cm_box.head_node = cm_bsp.bsp.num_nodes;
-
-	// planes
-	cm_box.planes = &cm_bsp.planes[cm_bsp.bsp.num_planes];
-
-	// leaf
-	cm_box.leaf = &cm_bsp.leafs[cm_bsp.bsp.num_leafs];
-	cm_box.leaf->contents = CONTENTS_MONSTER;
-	cm_box.leaf->first_leaf_brush = cm_bsp.bsp.num_leaf_brushes;
-	cm_box.leaf->num_leaf_brushes = 1;
-
-	// leaf brush
-	cm_bsp.leaf_brushes[cm_bsp.bsp.num_leaf_brushes] = cm_bsp.bsp.num_brushes;
-
-	// brush
-	cm_box.brush = &cm_bsp.brushes[cm_bsp.bsp.num_brushes];
-	cm_box.brush->num_sides = 6;
-	cm_box.brush->first_brush_side = cm_bsp.bsp.num_brush_sides;
-	cm_box.brush->contents = CONTENTS_MONSTER;
-
 	for (int32_t i = 0; i < 6; i++) {
 
 		// fill in planes, two per side
-		cm_bsp_plane_t *plane = &cm_box.planes[i * 2];
+		cm_bsp_plane_t *plane = &hull->planes[i * 2];
 		plane->type = i >> 1;
 		VectorClear(plane->normal);
 		plane->normal[i >> 1] = 1.0;
 		plane->sign_bits = Cm_SignBitsForPlane(plane);
 		plane->num = (cm_bsp.bsp.num_planes >> 1) + (i >> 1) + 1;
 
-		plane = &cm_box.planes[i * 2 + 1];
+		plane = &hull->planes[i * 2 + 1];
 		plane->type = PLANE_ANY_X + (i >> 1);
 		VectorClear(plane->normal);
 		plane->normal[i >> 1] = -1.0;
 		plane->sign_bits = Cm_SignBitsForPlane(plane);
 		plane->num = (cm_bsp.bsp.num_planes >> 1) + (i >> 1) + 1;
 
-		const int32_t side = i & 1;
-
-		// fill in nodes, one per side
-		cm_bsp_node_t *node = &cm_bsp.nodes[cm_box.head_node + i];
-		node->plane = cm_bsp.planes + (cm_bsp.bsp.num_planes + i * 2);
-		node->children[side] = -1 - cm_bsp.bsp.num_leafs;
-		if (i != 5) {
-			node->children[side ^ 1] = cm_box.head_node + i + 1;
-		} else {
-			node->children[side ^ 1] = -1 - cm_bsp.bsp.num_leafs;
-		}
-
 		// fill in brush sides, one per side
-		cm_bsp_brush_side_t *bside = &cm_bsp.brush_sides[cm_bsp.bsp.num_brush_sides + i];
-		bside->plane = cm_bsp.planes + (cm_bsp.bsp.num_planes + i * 2 + side);
-		bside->surface = &null_surface;
+		cm_bsp_brush_side_t *side = &hull->brush_sides[i];
+		side->plane = &hull->planes[i * 2 + (i & 1)];
+		side->surface = &null_surface;
 	}
-}
 
-/**
- * @brief Initializes the box hull for the specified bounds, returning the
- * head node for the resulting box hull tree.
- */
-int32_t Cm_SetBoxHull(const vec3_t mins, const vec3_t maxs, const int32_t contents) {
-
-	VectorCopy(mins, cm_box.brush->mins);
-	VectorCopy(maxs, cm_box.brush->maxs);
-
-	cm_box.planes[0].dist = maxs[0];
-	cm_box.planes[1].dist = -maxs[0];
-	cm_box.planes[2].dist = mins[0];
-	cm_box.planes[3].dist = -mins[0];
-	cm_box.planes[4].dist = maxs[1];
-	cm_box.planes[5].dist = -maxs[1];
-	cm_box.planes[6].dist = mins[1];
-	cm_box.planes[7].dist = -mins[1];
-	cm_box.planes[8].dist = maxs[2];
-	cm_box.planes[9].dist = -maxs[2];
-	cm_box.planes[10].dist = mins[2];
-	cm_box.planes[11].dist = -mins[2];
-
-	cm_box.leaf->contents = cm_box.brush->contents = contents;
-
-	return cm_box.head_node;
+	hull->planes[0].dist = maxs[0];
+	hull->planes[1].dist = -maxs[0];
+	hull->planes[2].dist = mins[0];
+	hull->planes[3].dist = -mins[0];
+	hull->planes[4].dist = maxs[1];
+	hull->planes[5].dist = -maxs[1];
+	hull->planes[6].dist = mins[1];
+	hull->planes[7].dist = -mins[1];
+	hull->planes[8].dist = maxs[2];
+	hull->planes[9].dist = -maxs[2];
+	hull->planes[10].dist = mins[2];
+	hull->planes[11].dist = -mins[2];
+
+	hull->brush.contents = contents;
+	hull->brush.num_sides = 6;
+	hull->brush.first_brush_side = 0;
+
+	VectorCopy(mins, hull->brush.mins);
+	VectorCopy(maxs, hull->brush.maxs);
 }
 
 /**
@@ -253,8 +175,14 @@ int32_t Cm_SetBoxHull(const vec3_t mins, const vec3_t maxs, const int32_t conten
 static int32_t Cm_PointLeafnum_r(const vec3_t p, int32_t num) {
 
 	while (num >= 0) {
-		const cm_bsp_node_t *node = cm_bsp.nodes + num;
-		const vec_t dist = Cm_DistanceToPlane(p, node->plane);
+		const cm_bsp_packed_node_t *node = cm_bsp.packed_nodes + num;
+
+		vec_t dist;
+		if (AXIAL(node)) {
+			dist = p[node->type] - node->dist;
+		} else {
+			dist = DotProduct(p, node->normal) - node->dist;
+		}
 
 		if (dist < 0.0) {
 			num = node->children[1];
@@ -300,18 +228,24 @@ int32_t Cm_PointContents(const vec3_t p, int32_t head_node) {
 /**
  * @brief Contents check for non-world models. Rotates and translates the point
  * into the model's space, and recurses the BSP tree. For inline BSP models,
- * the head node is the root of the model's subtree. For mesh models, a special
- * reserver box hull is used.
+ * the head node is the root of the model's subtree. For mesh models, the
+ * caller's box hull is used.
  *
  * @param p The point, in world space.
- * @param head_hode The BSP head node to recurse down.
+ * @param head_hode The BSP head node to recurse down, or -1 to use the box hull.
+ * @param hull The box hull, if head_node is -1.
  * @param inverse_matrix The inverse matrix of the entity to be tested.
  *
  * @return The contents mask at the specified point.
  */
-int32_t Cm_TransformedPointContents(const vec3_t p, int32_t head_node, const matrix4x4_t *inverse_matrix) {
+int32_t Cm_TransformedPointContents(const vec3_t p, int32_t head_node, const cm_box_hull_t *hull,
+                                    const matrix4x4_t *inverse_matrix) {
 	vec3_t p0;
 
+	if (head_node == -1) { // the box hull is a single leaf
+		return cm_bsp.bsp.num_nodes ? hull->brush.contents : 0;
+	}
+
 	Matrix4x4_Transform(inverse_matrix, p, p0);
 
 	return Cm_PointContents(p0, head_node);
@@ -21,6 +21,10 @@
 
 #include "cm_local.h"
 
+#if defined(__SSE__)
+	#include <xmmintrin.h>
+#endif
+
 /**
  * @brief Plane side epsilon (1.0 / 32.0) to keep floating point happy.
  */
@@ -40,27 +44,73 @@ typedef struct {
 	_Bool is_point;
 
 	cm_trace_t trace;
-
-	int32_t brushes[32]; // used to avoid multiple intersection tests with brushes
 } cm_trace_data_t;
 
 /**
- * @brief
+ * @brief Brushes spanning several leafs are tested once per trace by stamping
+ * them with the trace number. Each thread has its own stamps, so that traces are
+ * thread safe. They are not re-entrant within a thread: a trace begun while
+ * another is in progress on the same thread would reuse the stamps.
+ */
+static __thread struct {
+	uint32_t trace_num;
+	uint32_t brushes[MAX_BSP_BRUSHES];
+} cm_tested;
+
+/**
+ * @brief Begins a new trace for Cm_BrushAlreadyTested.
  */
-static _Bool Cm_BrushAlreadyTested(cm_trace_data_t *data, const int32_t brush_num) {
+static void Cm_BeginTrace(void) {
+
+	if (++cm_tested.trace_num == 0) { // wrapped, so clear stale stamps
+		memset(cm_tested.brushes, 0, sizeof(cm_tested.brushes));
+		cm_tested.trace_num = 1;
+	}
+}
+
+/**
+ * @return True if the brush was already tested by this trace, false otherwise.
+ */
+static _Bool Cm_BrushAlreadyTested(const int32_t brush_num) {
+
+	if (cm_tested.brushes[brush_num] == cm_tested.trace_num) {
+		return true;
+	}
+
+	cm_tested.brushes[brush_num] = cm_tested.trace_num;
+	return false;
+}
+
+/**
+ * @return True if the leaf brush matches the trace contents and intersects the
+ * trace bounds. The bounds test matches BoxIntersect.
+ */
+static inline _Bool Cm_LeafBrushIntersects(const cm_trace_data_t *data,
+                                           const cm_bsp_leaf_brush_t *leaf_brush) {
+
+	if (!(leaf_brush->contents & data->contents)) {
+		return false;
+	}
 
-	const int32_t hash = brush_num & 31;
-	const _Bool skip = (data->brushes[hash] == brush_num);
+#if defined(__SSE__)
+	const __m128 box_mins = _mm_setr_ps(data->box_mins[0], data->box_mins[1], data->box_mins[2], 0.0);
+	const __m128 box_maxs = _mm_setr_ps(data->box_maxs[0], data->box_maxs[1], data->box_maxs[2], 0.0);
 
-	data->brushes[hash] = brush_num;
+	// the fourth lanes hold the contents and brush number, and are ignored
+	const __m128 a = _mm_cmplt_ps(box_mins, _mm_loadu_ps(leaf_brush->maxs));
+	const __m128 b = _mm_cmpgt_ps(box_maxs, _mm_loadu_ps(leaf_brush->mins));
 
-	return skip;
+	return (_mm_movemask_ps(_mm_and_ps(a, b)) & 7) == 7;
+#else
+	return BoxIntersect(data->box_mins, data->box_maxs, leaf_brush->mins, leaf_brush->maxs);
+#endif
 }
 
 /**
  * @brief Clips the bounded box to all brush sides for the given brush.
  */
-static void Cm_TraceToBrush(cm_trace_data_t *data, const cm_bsp_brush_t *brush) {
+static void Cm_TraceToBrush(cm_trace_data_t *data, const cm_bsp_brush_t *brush,
+                            const cm_bsp_brush_side_t *brush_sides) {
 
 	if (!brush->num_sides) {
 		return;
@@ -78,7 +128,7 @@ static void Cm_TraceToBrush(cm_trace_data_t *data, const cm_bsp_brush_t *brush)
 
 	_Bool end_outside = false, start_outside = false;
 
-	const cm_bsp_brush_side_t *side = &cm_bsp.brush_sides[brush->first_brush_side];
+	const cm_bsp_brush_side_t *side = &brush_sides[brush->first_brush_side];
 
 	for (int32_t i = 0; i < brush->num_sides; i++, side++) {
 		const cm_bsp_plane_t *plane = side->plane;
@@ -145,7 +195,8 @@ static void Cm_TraceToBrush(cm_trace_data_t *data, const cm_bsp_brush_t *brush)
 /**
  * @brief
  */
-static void Cm_TestBoxInBrush(cm_trace_data_t *data, const cm_bsp_brush_t *brush) {
+static void Cm_TestBoxInBrush(cm_trace_data_t *data, const cm_bsp_brush_t *brush,
+                              const cm_bsp_brush_side_t *brush_sides) {
 
 	if (!brush->num_sides) {
 		return;
@@ -155,7 +206,7 @@ static void Cm_TestBoxInBrush(cm_trace_data_t *data, const cm_bsp_brush_t *brush
 		return;
 	}
 
-	const cm_bsp_brush_side_t *side = &cm_bsp.brush_sides[brush->first_brush_side];
+	const cm_bsp_brush_side_t *side = &brush_sides[brush->first_brush_side];
 
 	for (int32_t i = 0; i < brush->num_sides; i++, side++) {
 		const cm_bsp_plane_t *plane = side->plane;
@@ -187,24 +238,20 @@ static void Cm_TraceToLeaf(cm_trace_data_t *data, int32_t leaf_num) {
 		return;
 	}
 
-	// reset the brushes cache for this leaf
-	memset(data->brushes, 0xff, sizeof(data->brushes));
+	const cm_bsp_leaf_brush_t *leaf_brush = cm_bsp.leaf_brush_bounds + leaf->first_leaf_brush;
 
 	// trace line against all brushes in the leaf
-	for (int32_t i = 0; i < leaf->num_leaf_brushes; i++) {
-		const int32_t brush_num = cm_bsp.leaf_brushes[leaf->first_leaf_brush + i];
+	for (int32_t i = 0; i < leaf->num_leaf_brushes; i++, leaf_brush++) {
 
-		if (Cm_BrushAlreadyTested(data, brush_num)) {
-			continue;    // already checked this brush in another leaf
+		if (!Cm_LeafBrushIntersects(data, leaf_brush)) {
+			continue;
 		}
 
-		const cm_bsp_brush_t *b = &cm_bsp.brushes[brush_num];
-
-		if (!(b->contents & data->contents)) {
-			continue;
+		if (Cm_BrushAlreadyTested(leaf_brush->brush_num)) {
+			continue; // already checked this brush in another leaf
 		}
 
-		Cm_TraceToBrush(data, b);
+		Cm_TraceToBrush(data, &cm_bsp.brushes[leaf_brush->brush_num], cm_bsp.brush_sides);
 
 		if (data->trace.all_solid) {
 			return;
@@ -223,21 +270,20 @@ static void Cm_TestInLeaf(cm_trace_data_t *data, int32_t leaf_num) {
 		return;
 	}
 
-	// trace line against all brushes in the leaf
-	for (int32_t i = 0; i < leaf->num_leaf_brushes; i++) {
-		const int32_t brush_num = cm_bsp.leaf_brushes[leaf->first_leaf_brush + i];
+	const cm_bsp_leaf_brush_t *leaf_brush = cm_bsp.leaf_brush_bounds + leaf->first_leaf_brush;
 
-		if (Cm_BrushAlreadyTested(data, brush_num)) {
-			continue; // already checked this brush in another leaf
-		}
-
-		const cm_bsp_brush_t *b = &cm_bsp.brushes[brush_num];
+	// test the box against all brushes in the leaf
+	for (int32_t i = 0; i < leaf->num_leaf_brushes; i++, leaf_brush++) {
 
-		if (!(b->contents & data->contents)) {
+		if (!Cm_LeafBrushIntersects(data, leaf_brush)) {
 			continue;
 		}
 
-		Cm_TestBoxInBrush(data, b);
+		if (Cm_BrushAlreadyTested(leaf_brush->brush_num)) {
+			continue; // already checked this brush in another leaf
+		}
+
+		Cm_TestBoxInBrush(data, &cm_bsp.brushes[leaf_brush->brush_num], cm_bsp.brush_sides);
 
 		if (data->trace.all_solid) {
 			return;
@@ -263,23 +309,22 @@ static void Cm_TraceToNode(cm_trace_data_t *data, int32_t num, vec_t p1f, vec_t
 
 	// find the point distances to the separating plane
 	// and the offset for the size of the box
-	const cm_bsp_node_t *node = cm_bsp.nodes + num;
-	const cm_bsp_plane_t *plane = node->plane;
+	const cm_bsp_packed_node_t *node = cm_bsp.packed_nodes + num;
 
 	vec_t d1, d2, offset;
-	if (AXIAL(plane)) {
-		d1 = p1[plane->type] - plane->dist;
-		d2 = p2[plane->type] - plane->dist;
-		offset = data->extents[plane->type];
+	if (AXIAL(node)) {
+		d1 = p1[node->type] - node->dist;
+		d2 = p2[node->type] - node->dist;
+		offset = data->extents[node->type];
 	} else {
-		d1 = DotProduct(plane->normal, p1) - plane->dist;
-		d2 = DotProduct(plane->normal, p2) - plane->dist;
+		d1 = DotProduct(node->normal, p1) - node->dist;
+		d2 = DotProduct(node->normal, p2) - node->dist;
 		if (data->is_point) {
 			offset = 0.0;
 		} else
-			offset = fabsf(data->extents[0] * plane->normal[0])
-			         + fabsf(data->extents[1] * plane->normal[1])
-			         + fabsf(data->extents[2] * plane->normal[2]);
+			offset = fabsf(data->extents[0] * node->normal[0])
+			         + fabsf(data->extents[1] * node->normal[1])
+			         + fabsf(data->extents[2] * node->normal[2]);
 	}
 
 	// see which sides we need to consider
@@ -334,93 +379,135 @@ static void Cm_TraceToNode(cm_trace_data_t *data, int32_t num, vec_t p1f, vec_t
 }
 
 /**
- * @brief Primary collision detection entry point. This function recurses down
- * the BSP tree from the specified head node, clipping the desired movement to
- * brushes that match the specified contents mask.
- *
- * @param start The starting point.
- * @param end The desired end point.
- * @param mins The bounding box mins, in model space.
- * @param maxs The bounding box maxs, in model space.
- * @param head_node The BSP head node to recurse down.
- * @param contents The contents mask to clip to.
- *
- * @return The trace.
+ * @brief Prepares the trace data for clipping the specified movement.
  */
-cm_trace_t Cm_BoxTrace(const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs,
-                       const int32_t head_node, const int32_t contents) {
+static void Cm_InitTraceData(cm_trace_data_t *data, const vec3_t start, const vec3_t end,
+                             const vec3_t mins, const vec3_t maxs, const int32_t contents) {
 
-	static __thread cm_trace_data_t data;
-	memset(&data, 0, sizeof(data));
+	memset(data, 0, sizeof(*data));
 
-	data.trace.fraction = 1.0;
+	data->trace.fraction = 1.0;
 
-	if (!cm_bsp.bsp.num_nodes) { // map not loaded
-		return data.trace;
-	}
+	Cm_BeginTrace();
 
-	VectorCopy(start, data.start);
-	VectorCopy(end, data.end);
+	VectorCopy(start, data->start);
+	VectorCopy(end, data->end);
 
-	VectorCopy(mins, data.mins);
-	VectorCopy(maxs, data.maxs);
+	VectorCopy(mins, data->mins);
+	VectorCopy(maxs, data->maxs);
 
-	data.contents = contents;
+	data->contents = contents;
 
 	// check for point special case
 	if (VectorCompare(mins, vec3_origin) && VectorCompare(maxs, vec3_origin)) {
-		data.is_point = true;
+		data->is_point = true;
 	} else {
-		data.is_point = false;
+		data->is_point = false;
 
 		// extents allow planes to be shifted to account for the box size
-		data.extents[0] = -mins[0] > maxs[0] ? -mins[0] : maxs[0];
-		data.extents[1] = -mins[1] > maxs[1] ? -mins[1] : maxs[1];
-		data.extents[2] = -mins[2] > maxs[2] ? -mins[2] : maxs[2];
+		data->extents[0] = -mins[0] > maxs[0] ? -mins[0] : maxs[0];
+		data->extents[1] = -mins[1] > maxs[1] ? -mins[1] : maxs[1];
+		data->extents[2] = -mins[2] > maxs[2] ? -mins[2] : maxs[2];
 
 		// offsets provide sign bit lookups for fast plane tests
-		data.offsets[0][0] = mins[0];
-		data.offsets[0][1] = mins[1];
-		data.offsets[0][2] = mins[2];
+		data->offsets[0][0] = mins[0];
+		data->offsets[0][1] = mins[1];
+		data->offsets[0][2] = mins[2];
 
-		data.offsets[1][0] = maxs[0];
-		data.offsets[1][1] = mins[1];
-		data.offsets[1][2] = mins[2];
+		data->offsets[1][0] = maxs[0];
+		data->offsets[1][1] = mins[1];
+		data->offsets[1][2] = mins[2];
 
-		data.offsets[2][0] = mins[0];
-		data.offsets[2][1] = maxs[1];
-		data.offsets[2][2] = mins[2];
+		data->offsets[2][0] = mins[0];
+		data->offsets[2][1] = maxs[1];
+		data->offsets[2][2] = mins[2];
 
-		data.offsets[3][0] = maxs[0];
-		data.offsets[3][1] = maxs[1];
-		data.offsets[3][2] = mins[2];
+		data->offsets[3][0] = maxs[0];
+		data->offsets[3][1] = maxs[1];
+		data->offsets[3][2] = mins[2];
 
-		data.offsets[4][0] = mins[0];
-		data.offsets[4][1] = mins[1];
-		data.offsets[4][2] = maxs[2];
+		data->offsets[4][0] = mins[0];
+		data->offsets[4][1] = mins[1];
+		data->offsets[4][2] = maxs[2];
 
-		data.offsets[5][0] = maxs[0];
-		data.offsets[5][1] = mins[1];
-		data.offsets[5][2] = maxs[2];
+		data->offsets[5][0] = maxs[0];
+		data->offsets[5][1] = mins[1];
+		data->offsets[5][2] = maxs[2];
 
-		data.offsets[6][0] = mins[0];
-		data.offsets[6][1] = maxs[1];
-		data.offsets[6][2] = maxs[2];
+		data->offsets[6][0] = mins[0];
+		data->offsets[6][1] = maxs[1];
+		data->offsets[6][2] = maxs[2];
 
-		data.offsets[7][0] = maxs[0];
-		data.offsets[7][1] = maxs[1];
-		data.offsets[7][2] = maxs[2];
+		data->offsets[7][0] = maxs[0];
+		data->offsets[7][1] = maxs[1];
+		data->offsets[7][2] = maxs[2];
 	}
 
 	for (int32_t i = 0; i < 3; i++) {
 		if (start[i] < end[i]) {
-			data.box_mins[i] = start[i] + mins[i] - 1.0;
-			data.box_maxs[i] = end[i] + maxs[i] + 1.0;
+			data->box_mins[i] = start[i] + mins[i] - 1.0;
+			data->box_maxs[i] = end[i] + maxs[i] + 1.0;
 		} else {
-			data.box_mins[i] = end[i] + mins[i] - 1.0;
-			data.box_maxs[i] = start[i] + maxs[i] + 1.0;
+			data->box_mins[i] = end[i] + mins[i] - 1.0;
+			data->box_maxs[i] = start[i] + maxs[i] + 1.0;
 		}
 	}
+}
+
+/**
+ * @brief Sets the end point of the trace from its fraction.
+ */
+static void Cm_FinishTrace(cm_trace_data_t *data) {
+
+	if (data->trace.fraction == 0.0) {
+		VectorCopy(data->start, data->trace.end);
+	} else if (data->trace.fraction == 1.0) {
+		VectorCopy(data->end, data->trace.end);
+	} else {
+		VectorLerp(data->start, data->end, data->trace.fraction, data->trace.end);
+	}
+}
+
+/**
+ * @brief Clips the desired movement to the BSP tree from the specified head node, or to
+ * the box hull. The trace data is private to each call, and the brush stamps to each
+ * thread, so that traces are thread safe, but not re-entrant within a thread.
+ */
+static cm_trace_t Cm_BoxTrace_(const vec3_t start, const vec3_t end, const vec3_t mins,
+                               const vec3_t maxs, const int32_t head_node, const cm_box_hull_t *hull,
+                               const int32_t contents) {
+
+	cm_trace_data_t data;
+
+	if (!cm_bsp.bsp.num_nodes) { // map not loaded
+		memset(&data.trace, 0, sizeof(data.trace));
+		data.trace.fraction = 1.0;
+		return data.trace;
+	}
+
+	Cm_InitTraceData(&data, start, end, mins, maxs, contents);
+
+	// the box hull is a single leaf containing a single brush
+	if (head_node == -1) {
+
+		if (hull->brush.contents & data.contents) {
+			if (VectorCompare(start, end)) {
+				Cm_TestBoxInBrush(&data, &hull->brush, hull->brush_sides);
+			} else {
+				Cm_TraceToBrush(&data, &hull->brush, hull->brush_sides);
+			}
+		}
+
+		if (data.trace.fraction == 0.0 || VectorCompare(start, end)) {
+			VectorCopy(start, data.trace.end);
+		} else if (data.trace.fraction == 1.0) {
+			VectorCopy(end, data.trace.end);
+		} else {
+			VectorLerp(start, end, data.trace.fraction, data.trace.end);
+		}
+
+		return data.trace;
+	}
 
 	// check for position test special case
 	if (VectorCompare(start, end)) {
@@ -443,29 +530,223 @@ cm_trace_t Cm_BoxTrace(const vec3_t start, const vec3_t end, const vec3_t mins,
 
 	Cm_TraceToNode(&data, head_node, 0.0, 1.0, start, end);
 
-	if (data.trace.fraction == 0.0) {
-		VectorCopy(start, data.trace.end);
-	} else if (data.trace.fraction == 1.0) {
-		VectorCopy(end, data.trace.end);
+	Cm_FinishTrace(&data);
+
+	return data.trace;
+}
+
+/**
+ * @brief Primary collision detection entry point. This function recurses down
+ * the BSP tree from the specified head node, clipping the desired movement to
+ * brushes that match the specified contents mask.
+ *
+ * @param start The starting point.
+ * @param end The desired end point.
+ * @param mins The bounding box mins, in model space.
+ * @param maxs The bounding box maxs, in model space.
+ * @param head_node The BSP head node to recurse down.
+ * @param contents The contents mask to clip to.
+ *
+ * @return The trace.
+ */
+cm_trace_t Cm_BoxTrace(const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs,
+                       const int32_t head_node, const int32_t contents) {
+
+	return Cm_BoxTrace_(start, end, mins, maxs, head_node, NULL, contents);
+}
+
+/**
+ * @brief A packet of traces, stored as structure-of-arrays for SIMD side tests.
+ * Unused lanes duplicate the first trace, so that they never disagree.
+ */
+typedef struct {
+	vec_t start[3][CM_TRACE_PACKET];
+	vec_t end[3][CM_TRACE_PACKET];
+	vec3_t extents;
+	_Bool is_point;
+} cm_trace_packet_t;
+
+/**
+ * @return 0 if every trace in the packet lies in front of the node, 1 if every
+ * trace lies behind it, or -1 if the traces must continue separately. The tests
+ * match those of Cm_TraceToNode exactly.
+ */
+static int32_t Cm_TracePacketSide(const cm_trace_packet_t *packet, const cm_bsp_packed_node_t *node) {
+
+	vec_t offset;
+	if (AXIAL(node)) {
+		offset = packet->extents[node->type];
+	} else if (packet->is_point) {
+		offset = 0.0;
 	} else {
-		VectorLerp(start, end, data.trace.fraction, data.trace.end);
+		offset = fabsf(packet->extents[0] * node->normal[0])
+		         + fabsf(packet->extents[1] * node->normal[1])
+		         + fabsf(packet->extents[2] * node->normal[2]);
 	}
 
-	return data.trace;
+#if defined(__SSE__)
+	const __m128 front_offset = _mm_set1_ps(offset);
+	const __m128 back_offset = _mm_set1_ps(-offset);
+	const __m128 dist = _mm_set1_ps(node->dist);
+
+	__m128 front = _mm_cmpeq_ps(dist, dist);
+	__m128 back = front;
+
+	for (int32_t i = 0; i < CM_TRACE_PACKET; i += 4) {
+		__m128 d1, d2;
+
+		if (AXIAL(node)) {
+			d1 = _mm_sub_ps(_mm_loadu_ps(&packet->start[node->type][i]), dist);
+			d2 = _mm_sub_ps(_mm_loadu_ps(&packet->end[node->type][i]), dist);
+		} else {
+			const __m128 n0 = _mm_set1_ps(node->normal[0]);
+			const __m128 n1 = _mm_set1_ps(node->normal[1]);
+			const __m128 n2 = _mm_set1_ps(node->normal[2]);
+
+			d1 = _mm_add_ps(_mm_mul_ps(n0, _mm_loadu_ps(&packet->start[0][i])),
+			                _mm_mul_ps(n1, _mm_loadu_ps(&packet->start[1][i])));
+			d1 = _mm_add_ps(d1, _mm_mul_ps(n2, _mm_loadu_ps(&packet->start[2][i])));
+			d1 = _mm_sub_ps(d1, dist);
+
+			d2 = _mm_add_ps(_mm_mul_ps(n0, _mm_loadu_ps(&packet->end[0][i])),
+			                _mm_mul_ps(n1, _mm_loadu_ps(&packet->end[1][i])));
+			d2 = _mm_add_ps(d2, _mm_mul_ps(n2, _mm_loadu_ps(&packet->end[2][i])));
+			d2 = _mm_sub_ps(d2, dist);
+		}
+
+		const __m128 f = _mm_and_ps(_mm_cmpge_ps(d1, front_offset), _mm_cmpge_ps(d2, front_offset));
+		const __m128 b = _mm_andnot_ps(f, _mm_and_ps(_mm_cmple_ps(d1, back_offset),
+		                                             _mm_cmple_ps(d2, back_offset)));
+
+		front = _mm_and_ps(front, f);
+		back = _mm_and_ps(back, b);
+	}
+
+	if (_mm_movemask_ps(front) == 0xf) {
+		return 0;
+	}
+	if (_mm_movemask_ps(back) == 0xf) {
+		return 1;
+	}
+	return -1;
+#else
+	_Bool front = true, back = true;
+
+	for (int32_t i = 0; i < CM_TRACE_PACKET; i++) {
+		vec_t d1, d2;
+
+		if (AXIAL(node)) {
+			d1 = packet->start[node->type][i] - node->dist;
+			d2 = packet->end[node->type][i] - node->dist;
+		} else {
+			d1 = node->normal[0] * packet->start[0][i] + node->normal[1] * packet->start[1][i] +
+			     node->normal[2] * packet->start[2][i] - node->dist;
+			d2 = node->normal[0] * packet->end[0][i] + node->normal[1] * packet->end[1][i] +
+			     node->normal[2] * packet->end[2][i] - node->dist;
+		}
+
+		const _Bool f = d1 >= offset && d2 >= offset;
+
+		front = front && f;
+		back = back && !f && d1 <= -offset && d2 <= -offset;
+	}
+
+	return front ? 0 : back ? 1 : -1;
+#endif
+}
+
+/**
+ * @brief Traces many boxes of the same size at once. Traces are grouped in
+ * packets of CM_TRACE_PACKET, which descend the packed nodes together for as
+ * long as all of their segments lie on the same side of each node, before
+ * finishing separately. Coherent traces, such as those cast from a light to
+ * neighboring lightmap samples, or by particles and reachability tests in the
+ * same area, share most of their descent. The results are identical to those
+ * of Cm_BoxTrace.
+ *
+ * @param starts The starting points.
+ * @param ends The desired end points.
+ * @param mins The bounding box mins, in model space, shared by all traces.
+ * @param maxs The bounding box maxs, in model space, shared by all traces.
+ * @param count The number of traces.
+ * @param head_node The BSP head node to recurse down.
+ * @param contents The contents mask to clip to.
+ * @param traces The resulting traces, one per start and end point.
+ */
+void Cm_BoxTraceBatch(const vec3_t *starts, const vec3_t *ends, const vec3_t mins, const vec3_t maxs,
+                      const size_t count, const int32_t head_node, const int32_t contents,
+                      cm_trace_t *traces) {
+
+	if (!cm_bsp.bsp.num_nodes) { // map not loaded
+		for (size_t i = 0; i < count; i++) {
+			traces[i] = Cm_BoxTrace(starts[i], ends[i], mins, maxs, head_node, contents);
+		}
+		return;
+	}
+
+	cm_trace_packet_t packet;
+	cm_trace_data_t data;
+
+	// the box is shared, so resolve its extents once
+	Cm_InitTraceData(&data, vec3_origin, vec3_origin, mins, maxs, contents);
+
+	VectorCopy(data.extents, packet.extents);
+	packet.is_point = data.is_point;
+
+	for (size_t i = 0; i < count; i += CM_TRACE_PACKET) {
+		const size_t n = Min(count - i, (size_t) CM_TRACE_PACKET);
+
+		for (size_t j = 0; j < CM_TRACE_PACKET; j++) {
+			const size_t k = i + (j < n ? j : 0);
+
+			for (int32_t l = 0; l < 3; l++) {
+				packet.start[l][j] = starts[k][l];
+				packet.end[l][j] = ends[k][l];
+			}
+		}
+
+		int32_t num = head_node;
+
+		while (num >= 0) {
+			const cm_bsp_packed_node_t *node = cm_bsp.packed_nodes + num;
+
+			const int32_t side = Cm_TracePacketSide(&packet, node);
+			if (side == -1) {
+				break;
+			}
+
+			num = node->children[side];
+		}
+
+		for (size_t j = i; j < i + n; j++) {
+			if (VectorCompare(starts[j], ends[j])) { // position test
+				traces[j] = Cm_BoxTrace(starts[j], ends[j], mins, maxs, head_node, contents);
+				continue;
+			}
+
+			Cm_InitTraceData(&data, starts[j], ends[j], mins, maxs, contents);
+
+			Cm_TraceToNode(&data, num, 0.0, 1.0, starts[j], ends[j]);
+
+			Cm_FinishTrace(&data);
+
+			traces[j] = data.trace;
+		}
+	}
 }
 
 /**
  * @brief Collision detection for non-world models. Rotates the specified end
  * points into the model's space, and traces down the relevant subset of the
  * BSP tree. For inline BSP models, the head node is the root of the model's
- * subtree. For mesh models, a special reserved box hull and head node are
- * used.
+ * subtree. For mesh models, the caller's box hull is used.
  *
  * @param start The trace start point, in world space.
  * @param end The trace end point, in world space.
  * @param mins The bounding box mins, in model space.
  * @param maxs The bounding box maxs, in model space.
- * @param head_node The BSP head node to recurse down.
+ * @param head_node The BSP head node to recurse down, or -1 to use the box hull.
+ * @param hull The box hull, if head_node is -1.
  * @param contents The contents mask to clip to.
  * @param matrix The matrix of the entity to clip to.
  * @param inverse_matrix The inverse matrix of the entity to clip to.
@@ -473,8 +754,9 @@ cm_trace_t Cm_BoxTrace(const vec3_t start, const vec3_t end, const vec3_t mins,
  * @return The trace.
  */
 cm_trace_t Cm_TransformedBoxTrace(const vec3_t start, const vec3_t end, const vec3_t mins,
-                                  const vec3_t maxs, const int32_t head_node, const int32_t contents,
-                                  const matrix4x4_t *matrix, const matrix4x4_t *inverse_matrix) {
+                                  const vec3_t maxs, const int32_t head_node, const cm_box_hull_t *hull,
+                                  const int32_t contents, const matrix4x4_t *matrix,
+                                  const matrix4x4_t *inverse_matrix) {
 
 	vec3_t start0, end0;
 
@@ -482,7 +764,7 @@ cm_trace_t Cm_TransformedBoxTrace(const vec3_t start, const vec3_t end, const ve
 	Matrix4x4_Transform(inverse_matrix, end, end0);
 
 	// sweep the box through the model
-	cm_trace_t trace = Cm_BoxTrace(start0, end0, mins, maxs, head_node, contents);
+	cm_trace_t trace = Cm_BoxTrace_(start0, end0, mins, maxs, head_node, hull, contents);
 
 	if (trace.fraction < 1.0) { // transform the impacted plane
 		vec4_t plane;
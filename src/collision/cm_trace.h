@@ -26,9 +26,19 @@
 cm_trace_t Cm_BoxTrace(const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs,
                        const int32_t head_node, const int32_t contents);
 
+/**
+ * @brief The number of traces walked together by Cm_BoxTraceBatch.
+ */
+#define CM_TRACE_PACKET 8
+
+void Cm_BoxTraceBatch(const vec3_t *starts, const vec3_t *ends, const vec3_t mins, const vec3_t maxs,
+                      const size_t count, const int32_t head_node, const int32_t contents,
+                      cm_trace_t *traces);
+
 cm_trace_t Cm_TransformedBoxTrace(const vec3_t start, const vec3_t end, const vec3_t mins,
-                                  const vec3_t maxs, const int32_t head_node, const int32_t contents,
-                                  const matrix4x4_t *matrix, const matrix4x4_t *inverse_matrix);
+                                  const vec3_t maxs, const int32_t head_node, const cm_box_hull_t *hull,
+                                  const int32_t contents, const matrix4x4_t *matrix,
+                                  const matrix4x4_t *inverse_matrix);
 
 void Cm_EntityBounds(const solid_t solid, const vec3_t origin, const vec3_t angles,
                      const vec3_t mins, const vec3_t maxs, vec_t *bounds_mins, vec_t *bounds_maxs);
@@ -150,6 +150,19 @@ typedef struct {
 	int32_t children[2]; // negative numbers are leafs
 } cm_bsp_node_t;
 
+/**
+ * @brief The node layout walked by traces, with the plane inlined so that each
+ * node occupies half of a cache line. Packed nodes are numbered as the nodes
+ * they were built from, so head nodes index either array.
+ */
+typedef struct {
+	vec3_t normal;
+	vec_t dist;
+	int32_t type; // for AXIAL
+	int32_t children[2]; // negative numbers are leafs
+	int32_t unused;
+} cm_bsp_packed_node_t;
+
 typedef struct {
 	cm_bsp_plane_t *plane;
 	cm_bsp_texinfo_t *surface;
@@ -170,6 +183,29 @@ typedef struct {
 	vec3_t mins, maxs;
 } cm_bsp_brush_t;
 
+/**
+ * @brief The bounds and contents of each leaf brush, in leaf brush order, so that
+ * traces may reject a leaf's brushes without visiting them. The members are
+ * ordered so that the mins and maxs can each be loaded as a single vector.
+ */
+typedef struct {
+	vec3_t mins;
+	int32_t contents;
+	vec3_t maxs;
+	int32_t brush_num;
+} cm_bsp_leaf_brush_t;
+
+/**
+ * @brief Box hulls allow entities without inline BSP models to be clipped to as
+ * a single brush. They are owned by the caller, so that concurrent queries never
+ * share one. As the brush sides reference the planes, box hulls must not be copied.
+ */
+typedef struct {
+	cm_bsp_plane_t planes[12];
+	cm_bsp_brush_side_t brush_sides[6];
+	cm_bsp_brush_t brush;
+} cm_box_hull_t;
+
 typedef struct {
 	int32_t num_area_portals;
 	int32_t first_area_portal;
@@ -45,7 +45,14 @@
  * of core net messages or serialized data types change. The game and client
  * game maintain PROTOCOL_MINOR as well.
  */
-#define PROTOCOL_MAJOR		1023
+#define PROTOCOL_MAJOR		1024
+
+/**
+ * @brief The previous protocol major, which writes positions at full precision
+ * and field masks at fixed width. Servers still accept it from clients, and
+ * clients still read it from demos.
+ */
+#define PROTOCOL_MAJOR_LEGACY	1023
 
 /**
  * @brief The IP address of the master server, where the authoritative list of
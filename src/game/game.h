@@ -25,7 +25,7 @@
 #include "filesystem.h"
 #include "ai/ai.h"
 
-#define GAME_API_VERSION 9
+#define GAME_API_VERSION 10
 
 /**
  * @brief Server flags for g_entity_t.
@@ -202,6 +202,30 @@ typedef struct g_import_s {
 	void (*Free)(void *p);
 	void (*FreeTag)(mem_tag_t tag);
 
+	/**
+	 * @brief Submits a job to the thread pool.
+	 * @param run The job function.
+	 * @param data User data.
+	 * @param counter An optional counter to wait on with `WaitCounter`.
+	 */
+	void (*Submit)(ThreadRunFunc run, void *data, thread_counter_t *counter);
+
+	/**
+	 * @brief Runs the given function over `[0, count)` in ranges of `grain` indices,
+	 * returning when all ranges have completed.
+	 * @param count The number of indices.
+	 * @param grain The number of indices per job.
+	 * @param run The range function.
+	 * @param data User data.
+	 */
+	void (*ParallelFor)(size_t count, size_t grain, ThreadRangeFunc run, void *data);
+
+	/**
+	 * @brief Waits for all jobs submitted with the given counter to complete.
+	 * @param counter The counter.
+	 */
+	void (*WaitCounter)(thread_counter_t *counter);
+
 	/**
 	 * @brief Loads the specified file into the given buffer.
 	 * @param filename The game-relative filename.
@@ -20,7 +20,7 @@
  */
 
 #include <signal.h>
-#include <SDL_thread.h>
+#include <SDL_atomic.h>
 
 #include "mem.h"
 
@@ -35,12 +35,44 @@
 #define MEM_MAGIC 0x69696969
 typedef uint32_t mem_magic_t;
 
+/**
+ * @brief Blocks of up to MEM_MAX_CLASS_SIZE bytes, including their header and
+ * footer, are pooled in power-of-two size classes. Larger blocks are allocated
+ * from, and returned to, the system directly.
+ */
+#define MEM_MIN_CLASS_SIZE 128
+#define MEM_MAX_CLASS_SIZE 16384
+#define MEM_CLASSES 8
+#define MEM_CLASS_NONE 0xff
+
+/**
+ * @brief Pooled blocks are carved from slabs of this size.
+ */
+#define MEM_SLAB_SIZE (MEM_MAX_CLASS_SIZE * 8)
+
+/**
+ * @brief The number of free blocks moved between a thread's cache and the
+ * shared depot at once, and the most that a thread may cache per class.
+ */
+#define MEM_BATCH 32
+#define MEM_CACHE_MAX (MEM_BATCH * 2)
+
+/**
+ * @brief Root blocks are spread across this many independently locked lists.
+ */
+#define MEM_STRIPES 64
+
 typedef struct mem_block_s {
 	mem_magic_t magic;
 	mem_tag_t tag; // for group free
 	struct mem_block_s *parent;
-	GSList *children;
+	struct mem_block_s *children; // the first child
+	struct mem_block_s *prev, *next; // siblings, stripe neighbours or free list
 	size_t size;
+	size_t capacity; // the usable size of the block
+	SDL_SpinLock lock; // guards children
+	uint8_t size_class;
+	uint8_t stripe;
 #if defined(SUPER_MEMORY_CHECKS)
 	void *stack[MAX_MEMORY_STACK];
 #endif
@@ -50,14 +82,66 @@ typedef struct {
 	mem_magic_t magic;
 } mem_footer_t;
 
+/**
+ * @brief A list of root blocks (blocks without a parent).
+ */
 typedef struct {
-	GHashTable *blocks;
-	size_t size;
-	SDL_mutex *lock;
+	mem_block_t *blocks;
+	SDL_SpinLock lock;
+} mem_stripe_t;
+
+/**
+ * @brief A list of free blocks of a single size class.
+ */
+typedef struct {
+	mem_block_t *blocks;
+	uint32_t count;
+} mem_free_list_t;
+
+/**
+ * @brief The shared free list for a size class, which threads exchange batches
+ * of blocks with.
+ */
+typedef struct {
+	mem_free_list_t free;
+	SDL_SpinLock lock;
+} mem_depot_t;
+
+/**
+ * @brief Slabs are retained until the memory subsystem is shut down.
+ */
+typedef struct mem_slab_s {
+	struct mem_slab_s *next;
+} mem_slab_t;
+
+typedef struct {
+	mem_stripe_t stripes[MEM_STRIPES];
+	mem_depot_t depots[MEM_CLASSES];
+
+	mem_slab_t *slabs;
+	SDL_SpinLock slabs_lock;
+
+	volatile gsize size;
 } mem_state_t;
 
 static mem_state_t mem_state;
 
+/**
+ * @brief Each thread allocates from, and frees to, its own cache of blocks.
+ */
+typedef struct {
+	uint32_t generation;
+	mem_free_list_t free[MEM_CLASSES];
+} mem_cache_t;
+
+static __thread mem_cache_t mem_cache;
+
+/**
+ * @brief Incremented by Mem_Init, so that thread caches which refer to the
+ * slabs of a previous initialization are discarded.
+ */
+static volatile gint mem_generation;
+
 #if defined(SUPER_MEMORY_CHECKS)
 /**
  * @brief
@@ -127,6 +211,251 @@ void Mem_Check(void *p) {
 	Mem_CheckMagic(p);
 }
 
+/**
+ * @return The total size of a memory block.
+ */
+static size_t Mem_BlockSize(const size_t size) {
+	return size + sizeof(mem_block_t) + sizeof(mem_footer_t);
+}
+
+/**
+ * @return The size class for a block of the specified total size, or
+ * MEM_CLASS_NONE if it is too large to be pooled.
+ */
+static uint8_t Mem_SizeClass(const size_t block_size) {
+
+	uint8_t c = 0;
+	for (size_t s = MEM_MIN_CLASS_SIZE; s < block_size; s <<= 1) {
+		if (++c == MEM_CLASSES) {
+			return MEM_CLASS_NONE;
+		}
+	}
+
+	return c;
+}
+
+/**
+ * @return The total size of blocks in the specified size class.
+ */
+static size_t Mem_ClassSize(const uint8_t size_class) {
+	return (size_t) MEM_MIN_CLASS_SIZE << size_class;
+}
+
+/**
+ * @return The calling thread's block cache.
+ */
+static mem_cache_t *Mem_Cache(void) {
+
+	const uint32_t generation = (uint32_t) g_atomic_int_get(&mem_generation);
+
+	if (mem_cache.generation != generation) {
+		memset(&mem_cache, 0, sizeof(mem_cache));
+		mem_cache.generation = generation;
+	}
+
+	return &mem_cache;
+}
+
+/**
+ * @brief Moves up to `count` blocks from one free list to another.
+ */
+static void Mem_MoveBlocks(mem_free_list_t *from, mem_free_list_t *to, uint32_t count) {
+
+	while (from->blocks && count--) {
+		mem_block_t *b = from->blocks;
+
+		from->blocks = b->next;
+		from->count--;
+
+		b->next = to->blocks;
+		to->blocks = b;
+		to->count++;
+	}
+}
+
+/**
+ * @brief Refills the free list with a batch of blocks from the shared depot,
+ * or by carving a new slab if the depot is empty.
+ */
+static void Mem_RefillBlocks(mem_free_list_t *free, const uint8_t size_class) {
+
+	mem_depot_t *depot = &mem_state.depots[size_class];
+
+	SDL_AtomicLock(&depot->lock);
+	Mem_MoveBlocks(&depot->free, free, MEM_BATCH);
+	SDL_AtomicUnlock(&depot->lock);
+
+	if (free->blocks) {
+		return;
+	}
+
+	mem_slab_t *slab = malloc(MEM_SLAB_SIZE);
+	if (!slab) {
+		fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) MEM_SLAB_SIZE);
+		raise(SIGABRT);
+		return;
+	}
+
+	SDL_AtomicLock(&mem_state.slabs_lock);
+	slab->next = mem_state.slabs;
+	mem_state.slabs = slab;
+	SDL_AtomicUnlock(&mem_state.slabs_lock);
+
+	// the slab header occupies the first block
+	const size_t size = Mem_ClassSize(size_class);
+	byte *data = ((byte *) slab) + Mem_ClassSize(0);
+
+	while (data + size <= ((byte *) slab) + MEM_SLAB_SIZE) {
+		mem_block_t *b = (mem_block_t *) data;
+
+		b->next = free->blocks;
+		free->blocks = b;
+		free->count++;
+
+		data += size;
+	}
+}
+
+/**
+ * @brief Allocates a zeroed block with room for `size` bytes, from the calling
+ * thread's cache where possible.
+ */
+static mem_block_t *Mem_AllocBlock(const size_t size) {
+	mem_block_t *b;
+
+	const size_t s = Mem_BlockSize(size);
+	const uint8_t size_class = Mem_SizeClass(s);
+
+	if (size_class == MEM_CLASS_NONE) {
+
+		if (!(b = calloc(s, 1))) {
+			fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) s);
+			raise(SIGABRT);
+			return NULL;
+		}
+
+		b->capacity = size;
+	} else {
+		mem_free_list_t *free = &Mem_Cache()->free[size_class];
+
+		if (!free->blocks) {
+			Mem_RefillBlocks(free, size_class);
+		}
+
+		b = free->blocks;
+
+		free->blocks = b->next;
+		free->count--;
+
+		memset(b, 0, s);
+
+		b->capacity = Mem_ClassSize(size_class) - Mem_BlockSize(0);
+	}
+
+	b->size_class = size_class;
+	return b;
+}
+
+/**
+ * @brief Returns the block to the calling thread's cache, or to the system.
+ * Excess cached blocks are returned to the shared depot.
+ */
+static void Mem_ReleaseBlock(mem_block_t *b) {
+
+	b->magic = 0;
+
+	if (b->size_class == MEM_CLASS_NONE) {
+		free(b);
+		return;
+	}
+
+	mem_free_list_t *free = &Mem_Cache()->free[b->size_class];
+
+	b->next = free->blocks;
+	free->blocks = b;
+	free->count++;
+
+	if (free->count > MEM_CACHE_MAX) {
+		mem_depot_t *depot = &mem_state.depots[b->size_class];
+
+		SDL_AtomicLock(&depot->lock);
+		Mem_MoveBlocks(free, &depot->free, MEM_BATCH);
+		SDL_AtomicUnlock(&depot->lock);
+	}
+}
+
+/**
+ * @brief Writes the size and footer of the specified block.
+ */
+static void Mem_SetSize(mem_block_t *b, const size_t size) {
+
+	b->size = size;
+
+	mem_footer_t *footer = (mem_footer_t *) (((byte *) (b + 1)) + size);
+	footer->magic = (mem_magic_t) (MEM_MAGIC + size);
+}
+
+/**
+ * @return The list, and its lock, which the block is linked into.
+ */
+static mem_block_t **Mem_BlockList(const mem_block_t *b, SDL_SpinLock **lock) {
+
+	if (b->parent) {
+		*lock = &b->parent->lock;
+		return &b->parent->children;
+	} else {
+		mem_stripe_t *stripe = &mem_state.stripes[b->stripe];
+		*lock = &stripe->lock;
+		return &stripe->blocks;
+	}
+}
+
+/**
+ * @brief Links the block into its parent's children, or into its stripe if
+ * it has no parent.
+ */
+static void Mem_LinkBlock(mem_block_t *b) {
+	SDL_SpinLock *lock;
+
+	mem_block_t **list = Mem_BlockList(b, &lock);
+
+	SDL_AtomicLock(lock);
+
+	b->prev = NULL;
+	b->next = *list;
+
+	if (*list) {
+		(*list)->prev = b;
+	}
+
+	*list = b;
+
+	SDL_AtomicUnlock(lock);
+}
+
+/**
+ * @brief Removes the block from the list it is linked into.
+ */
+static void Mem_UnlinkBlock(mem_block_t *b) {
+	SDL_SpinLock *lock;
+
+	mem_block_t **list = Mem_BlockList(b, &lock);
+
+	SDL_AtomicLock(lock);
+
+	if (b->prev) {
+		b->prev->next = b->next;
+	} else {
+		*list = b->next;
+	}
+
+	if (b->next) {
+		b->next->prev = b->prev;
+	}
+
+	SDL_AtomicUnlock(lock);
+}
+
 /**
  * @brief Recursively frees linked managed memory.
  */
@@ -137,14 +466,17 @@ static void Mem_Free_(mem_block_t *b) {
 #endif
 
 	// recurse down the tree, freeing children
-	if (b->children) {
-		g_slist_free_full(b->children, (GDestroyNotify) Mem_Free_);
+	mem_block_t *child = b->children;
+	while (child) {
+		mem_block_t *next = child->next;
+		Mem_Free_(child);
+		child = next;
 	}
 
 	// decrement the pool size and free the memory
-	mem_state.size -= b->size;
+	g_atomic_pointer_add(&mem_state.size, -(gssize) b->size);
 
-	free(b);
+	Mem_ReleaseBlock(b);
 }
 
 /**
@@ -155,17 +487,9 @@ void Mem_Free(void *p) {
 	if (p) {
 		mem_block_t *b = Mem_CheckMagic(p);
 
-		SDL_mutexP(mem_state.lock);
-
-		if (b->parent) {
-			b->parent->children = g_slist_remove(b->parent->children, b);
-		} else {
-			g_hash_table_remove(mem_state.blocks, (gconstpointer) b);
-		}
+		Mem_UnlinkBlock(b);
 
 		Mem_Free_(b);
-
-		SDL_mutexV(mem_state.lock);
 	}
 }
 
@@ -173,30 +497,46 @@ void Mem_Free(void *p) {
  * @brief Free all managed items allocated with the specified tag.
  */
 void Mem_FreeTag(mem_tag_t tag) {
-	GHashTableIter it;
-	gpointer key, value;
 
-	SDL_mutexP(mem_state.lock);
+	for (size_t i = 0; i < MEM_STRIPES; i++) {
+		mem_stripe_t *stripe = &mem_state.stripes[i];
+		mem_block_t *blocks = NULL;
+
+		// detach the matching blocks while holding the lock
+		SDL_AtomicLock(&stripe->lock);
+
+		mem_block_t *b = stripe->blocks;
+		while (b) {
+			mem_block_t *next = b->next;
 
-	g_hash_table_iter_init(&it, mem_state.blocks);
+			if (tag == MEM_TAG_ALL || b->tag == tag) {
 
-	while (g_hash_table_iter_next(&it, &key, &value)) {
-		mem_block_t *b = (mem_block_t *) key;
+				if (b->prev) {
+					b->prev->next = b->next;
+				} else {
+					stripe->blocks = b->next;
+				}
 
-		if (tag == MEM_TAG_ALL || b->tag == tag) {
-			g_hash_table_iter_remove(&it);
-			Mem_Free_(b);
+				if (b->next) {
+					b->next->prev = b->prev;
+				}
+
+				b->next = blocks;
+				blocks = b;
+			}
+
+			b = next;
 		}
-	}
 
-	SDL_mutexV(mem_state.lock);
-}
+		SDL_AtomicUnlock(&stripe->lock);
 
-/**
- * @brief Returns the total size of a memory block.
- */
-static size_t Mem_BlockSize(const size_t size) {
-	return size + sizeof(mem_block_t) + sizeof(mem_footer_t);
+		// and free them without it
+		while (blocks) {
+			mem_block_t *next = blocks->next;
+			Mem_Free_(blocks);
+			blocks = next;
+		}
+	}
 }
 
 /**
@@ -211,46 +551,28 @@ static size_t Mem_BlockSize(const size_t size) {
  * @return A block of managed memory initialized to 0x0.
  */
 static void *Mem_Malloc_(size_t size, mem_tag_t tag, void *parent) {
-	mem_block_t *b, *p = Mem_CheckMagic(parent);
-
-	// allocate the block plus the desired size
-	const size_t s = Mem_BlockSize(size);
+	mem_block_t *p = Mem_CheckMagic(parent);
 
-	if (!(b = calloc(s, 1))) {
-		fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) s);
-		raise(SIGABRT);
-		return NULL;
-	}
+	mem_block_t *b = Mem_AllocBlock(size);
 
 	b->magic = MEM_MAGIC;
 	b->tag = tag;
 	b->parent = p;
-	b->size = size;
-
-	void *data = (void *) (b + 1);
+	b->stripe = (uint8_t) ((((uintptr_t) b) >> 7) % MEM_STRIPES);
 
-	mem_footer_t *footer = (mem_footer_t *) (((byte *) data) + size);
-	footer->magic = (mem_magic_t) (MEM_MAGIC + b->size);
-
-	// insert it into the managed memory structures
-	SDL_mutexP(mem_state.lock);
-
-	if (b->parent) {
-		b->parent->children = g_slist_prepend(b->parent->children, b);
-	} else {
-		g_hash_table_add(mem_state.blocks, b);
-	}
+	Mem_SetSize(b, size);
 
-	mem_state.size += size;
-	
 #if defined(SUPER_MEMORY_CHECKS)
 	Mem_SetStack(b);
 #endif
 
-	SDL_mutexV(mem_state.lock);
+	// insert it into the managed memory structures
+	Mem_LinkBlock(b);
+
+	g_atomic_pointer_add(&mem_state.size, (gssize) size);
 
 	// return the address in front of the block
-	return data;
+	return (void *) (b + 1);
 }
 
 /**
@@ -302,56 +624,82 @@ void *Mem_Realloc(void *p, size_t size) {
 		return Mem_Malloc(size);
 	}
 
-	mem_block_t *b = Mem_CheckMagic(p), *new_b;
+	mem_block_t *b = Mem_CheckMagic(p);
 
 	// no change to size
 	if (b->size == size) {
 		return (void *) (b + 1);
 	}
 
-	// allocate the block plus the desired size
 	const size_t old_size = b->size;
-	const size_t s = Mem_BlockSize(size);
 
-	b->size = size;
+	g_atomic_pointer_add(&mem_state.size, (gssize) size - (gssize) old_size);
+
+	// resize pooled blocks in place if they are large enough
+	if (b->size_class != MEM_CLASS_NONE && size <= b->capacity) {
+		Mem_SetSize(b, size);
+		return (void *) (b + 1);
+	}
 
 #if defined(SUPER_MEMORY_PRINTS)
 	Mem_Print(b, "Reallocating");
 #endif
 
-	if (!(new_b = realloc(b, s))) {
-		fprintf(stderr, "Failed to re-allocate %u bytes\n", (uint32_t) s);
-		raise(SIGABRT);
-		return NULL;
-	}
+	// hold the lock of our parent or stripe while we move
+	SDL_SpinLock *lock;
+	mem_block_t **list = Mem_BlockList(b, &lock);
 
-	void *data = (void *) (new_b + 1);
+	SDL_AtomicLock(lock);
 
-	mem_footer_t *footer = (mem_footer_t *) (((byte *) data) + size);
-	footer->magic = (mem_magic_t) (MEM_MAGIC + new_b->size);
+	mem_block_t *new_b;
 
-	SDL_mutexP(mem_state.lock);
+	const size_t s = Mem_BlockSize(size);
+
+	if (b->size_class == MEM_CLASS_NONE && Mem_SizeClass(s) == MEM_CLASS_NONE) {
+
+		if (!(new_b = realloc(b, s))) {
+			fprintf(stderr, "Failed to re-allocate %u bytes\n", (uint32_t) s);
+			raise(SIGABRT);
+			return NULL;
+		}
 
-	// re-seat us in our parent or in global hash list
-	if (new_b->parent) {
-		new_b->parent->children = g_slist_remove(new_b->parent->children, b);
-		new_b->parent->children = g_slist_prepend(new_b->parent->children, new_b);
+		new_b->capacity = size;
 	} else {
-		g_hash_table_remove(mem_state.blocks, b);
-		g_hash_table_add(mem_state.blocks, new_b);
+		new_b = Mem_AllocBlock(size);
+
+		new_b->magic = MEM_MAGIC;
+		new_b->tag = b->tag;
+		new_b->parent = b->parent;
+		new_b->children = b->children;
+		new_b->prev = b->prev;
+		new_b->next = b->next;
+		new_b->stripe = b->stripe;
+
+		memcpy(new_b + 1, b + 1, MIN(old_size, size));
+
+		Mem_ReleaseBlock(b);
+	}
+
+	Mem_SetSize(new_b, size);
+
+	// re-seat us in our parent or in our stripe
+	if (new_b->prev) {
+		new_b->prev->next = new_b;
+	} else {
+		*list = new_b;
 	}
 
+	if (new_b->next) {
+		new_b->next->prev = new_b;
+	}
+
+	SDL_AtomicUnlock(lock);
+
 	// change our childrens' parent pointers
-	if (new_b->children) {
-		for (GSList *children = new_b->children; children; children = children->next) {
-			mem_block_t *child = (mem_block_t *) children->data;
-			child->parent = new_b;
-		}
+	for (mem_block_t *child = new_b->children; child; child = child->next) {
+		child->parent = new_b;
 	}
 
-	mem_state.size -= old_size;
-	mem_state.size += size;
-	
 #if defined(SUPER_MEMORY_CHECKS)
 	Mem_SetStack(new_b);
 
@@ -360,9 +708,7 @@ void *Mem_Realloc(void *p, size_t size) {
 #endif
 #endif
 
-	SDL_mutexV(mem_state.lock);
-
-	return data;
+	return (void *) (new_b + 1);
 }
 
 /**
@@ -378,18 +724,11 @@ void *Mem_Link(void *child, void *parent) {
 	mem_block_t *c = Mem_CheckMagic(child);
 	mem_block_t *p = Mem_CheckMagic(parent);
 
-	SDL_mutexP(mem_state.lock);
-
-	if (c->parent) {
-		c->parent->children = g_slist_remove(c->parent->children, c);
-	} else {
-		g_hash_table_remove(mem_state.blocks, c);
-	}
+	Mem_UnlinkBlock(c);
 
 	c->parent = p;
-	p->children = g_slist_prepend(p->children, c);
 
-	SDL_mutexV(mem_state.lock);
+	Mem_LinkBlock(c);
 
 	return child;
 }
@@ -398,7 +737,7 @@ void *Mem_Link(void *child, void *parent) {
  * @return The current size (user bytes) of the zone allocation pool.
  */
 size_t Mem_Size(void) {
-	return mem_state.size;
+	return (size_t) mem_state.size;
 }
 
 /**
@@ -421,6 +760,109 @@ char *Mem_CopyString(const char *in) {
 	return Mem_TagCopyString(in, MEM_TAG_DEFAULT);
 }
 
+/**
+ * @brief Arena allocations are aligned to this many bytes.
+ */
+#define MEM_ARENA_ALIGN 16
+
+/**
+ * @brief A chunk of arena memory. Chunks are linked to their arena, and are
+ * retained when it is reset.
+ */
+typedef struct mem_arena_chunk_s {
+	struct mem_arena_chunk_s *next;
+	size_t size; // usable bytes
+	size_t used;
+} mem_arena_chunk_t;
+
+/**
+ * @brief The offset of the usable bytes within an arena chunk.
+ */
+#define MEM_ARENA_CHUNK_DATA ((sizeof(mem_arena_chunk_t) + MEM_ARENA_ALIGN - 1) & ~(MEM_ARENA_ALIGN - 1))
+
+struct mem_arena_s {
+	mem_arena_chunk_t *chunks;
+	mem_arena_chunk_t *chunk; // the chunk currently being allocated from
+	size_t chunk_size;
+};
+
+/**
+ * @brief Allocates a chunk of at least `size` usable bytes for the arena.
+ */
+static mem_arena_chunk_t *Mem_ArenaChunk(mem_arena_t *arena, size_t size) {
+
+	mem_arena_chunk_t *chunk = Mem_LinkMalloc(MEM_ARENA_CHUNK_DATA + size, arena);
+	chunk->size = size;
+
+	return chunk;
+}
+
+/**
+ * @brief Creates an arena, from which transient allocations may be made and
+ * then released all at once with Mem_ResetArena. Arenas are not thread safe.
+ *
+ * @param size The size of each chunk of the arena, which should accommodate a
+ * typical frame's allocations.
+ * @param tag The tag to allocate the arena with. The arena and all of its
+ * chunks are accounted for, and freed, with this tag.
+ */
+mem_arena_t *Mem_CreateArena(size_t size, mem_tag_t tag) {
+
+	mem_arena_t *arena = Mem_TagMalloc(sizeof(mem_arena_t), tag);
+
+	arena->chunk_size = size;
+	arena->chunks = arena->chunk = Mem_ArenaChunk(arena, size);
+
+	return arena;
+}
+
+/**
+ * @brief Allocates from the specified arena, adding a chunk if necessary.
+ *
+ * @return A block of memory initialized to 0x0, which is valid until the arena
+ * is reset or destroyed. It must not be passed to Mem_Free.
+ */
+void *Mem_ArenaMalloc(mem_arena_t *arena, size_t size) {
+
+	size = (size + MEM_ARENA_ALIGN - 1) & ~(MEM_ARENA_ALIGN - 1);
+
+	mem_arena_chunk_t *chunk = arena->chunk;
+
+	while (chunk->used + size > chunk->size) {
+
+		if (chunk->next == NULL) {
+			chunk->next = Mem_ArenaChunk(arena, MAX(arena->chunk_size, size));
+		}
+
+		chunk = arena->chunk = chunk->next;
+	}
+
+	void *data = ((byte *) chunk) + MEM_ARENA_CHUNK_DATA + chunk->used;
+	chunk->used += size;
+
+	memset(data, 0, size);
+	return data;
+}
+
+/**
+ * @brief Releases all allocations made from the arena, retaining its chunks.
+ */
+void Mem_ResetArena(mem_arena_t *arena) {
+
+	for (mem_arena_chunk_t *chunk = arena->chunks; chunk; chunk = chunk->next) {
+		chunk->used = 0;
+	}
+
+	arena->chunk = arena->chunks;
+}
+
+/**
+ * @brief Frees the arena and all of its chunks.
+ */
+void Mem_DestroyArena(mem_arena_t *arena) {
+	Mem_Free(arena);
+}
+
 /**
  * @brief
  */
@@ -431,14 +873,18 @@ static gint Mem_Stats_Sort(gconstpointer a, gconstpointer b) {
 /**
  * @brief
  */
-static size_t Mem_CalculateBlockSize(const mem_block_t *b) {
+static size_t Mem_CalculateBlockSize(mem_block_t *b) {
 
 	size_t size = b->size;
 
-	for (GSList *child = b->children; child; child = child->next) {
-		size += Mem_CalculateBlockSize((const mem_block_t *) child->data);
+	SDL_AtomicLock(&b->lock);
+
+	for (mem_block_t *child = b->children; child; child = child->next) {
+		size += Mem_CalculateBlockSize(child);
 	}
 
+	SDL_AtomicUnlock(&b->lock);
+
 	return size;
 }
 
@@ -447,48 +893,46 @@ static size_t Mem_CalculateBlockSize(const mem_block_t *b) {
  */
 GArray *Mem_Stats(void) {
 
-	GHashTableIter it;
-	gpointer key, value;
-
-	SDL_mutexP(mem_state.lock);
-
 	GArray *stat_array = g_array_new(false, true, sizeof(mem_stat_t));
 
 	stat_array = g_array_append_vals(stat_array, &(const mem_stat_t) {
 		.tag = -1,
-		 .size = mem_state.size,
+		 .size = Mem_Size(),
 		  .count = 0
 	}, 1);
 
-	g_hash_table_iter_init(&it, mem_state.blocks);
+	for (size_t i = 0; i < MEM_STRIPES; i++) {
+		mem_stripe_t *stripe = &mem_state.stripes[i];
+
+		SDL_AtomicLock(&stripe->lock);
 
-	while (g_hash_table_iter_next(&it, &key, &value)) {
-		const mem_block_t *b = (const mem_block_t *) key;
-		mem_stat_t *stats = NULL;
+		for (mem_block_t *b = stripe->blocks; b; b = b->next) {
+			mem_stat_t *stats = NULL;
 
-		for (size_t i = 0; i < stat_array->len; i++) {
+			for (size_t j = 0; j < stat_array->len; j++) {
 
-			mem_stat_t *stat_i = &g_array_index(stat_array, mem_stat_t, i);
+				mem_stat_t *stat_j = &g_array_index(stat_array, mem_stat_t, j);
 
-			if (stat_i->tag == b->tag) {
-				stats = stat_i;
-				break;
+				if (stat_j->tag == b->tag) {
+					stats = stat_j;
+					break;
+				}
 			}
-		}
 
-		if (stats == NULL) {
-			stat_array = g_array_append_vals(stat_array, &(const mem_stat_t) {
-				.tag = b->tag,
-				 .size = Mem_CalculateBlockSize(b),
-				  .count = 1
-			}, 1);
-		} else {
-			stats->size += Mem_CalculateBlockSize(b);
-			stats->count++;
+			if (stats == NULL) {
+				stat_array = g_array_append_vals(stat_array, &(const mem_stat_t) {
+					.tag = b->tag,
+					 .size = Mem_CalculateBlockSize(b),
+					  .count = 1
+				}, 1);
+			} else {
+				stats->size += Mem_CalculateBlockSize(b);
+				stats->count++;
+			}
 		}
-	}
 
-	SDL_mutexV(mem_state.lock);
+		SDL_AtomicUnlock(&stripe->lock);
+	}
 
 	g_array_sort(stat_array, Mem_Stats_Sort);
 
@@ -503,9 +947,7 @@ void Mem_Init(void) {
 
 	memset(&mem_state, 0, sizeof(mem_state));
 
-	mem_state.blocks = g_hash_table_new(g_direct_hash, g_direct_equal);
-
-	mem_state.lock = SDL_CreateMutex();
+	g_atomic_int_inc(&mem_generation);
 }
 
 /**
@@ -516,7 +958,12 @@ void Mem_Shutdown(void) {
 
 	Mem_FreeTag(MEM_TAG_ALL);
 
-	g_hash_table_destroy(mem_state.blocks);
+	while (mem_state.slabs) {
+		mem_slab_t *slab = mem_state.slabs;
+		mem_state.slabs = slab->next;
+		free(slab);
+	}
 
-	SDL_DestroyMutex(mem_state.lock);
+	// discard any thread caches, which refer to the slabs we just freed
+	g_atomic_int_inc(&mem_generation);
 }
@@ -35,6 +35,16 @@ char *Mem_TagCopyString(const char *in, mem_tag_t tag);
 char *Mem_CopyString(const char *in);
 void Mem_Check(void *p);
 
+/**
+ * @brief An arena (bump) allocator for transient, e.g. per-frame, memory.
+ */
+typedef struct mem_arena_s mem_arena_t;
+
+mem_arena_t *Mem_CreateArena(size_t size, mem_tag_t tag);
+void *Mem_ArenaMalloc(mem_arena_t *arena, size_t size);
+void Mem_ResetArena(mem_arena_t *arena);
+void Mem_DestroyArena(mem_arena_t *arena);
+
 /**
  * @brief Struct used for return values of Mem_Stats
  */
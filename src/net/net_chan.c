@@ -149,14 +149,21 @@ static _Bool Netchan_CheckRetransmit(net_chan_t *chan) {
 }
 
 /**
- * @brief Tries to send an unreliable message to a connection, and handles the
- * transmission / retransmission of the reliable messages.
+ * @brief Tries to send an unreliable message, gathered from the given segments,
+ * to a connection, and handles the transmission / retransmission of the
+ * reliable messages. The packet header is written to a small buffer of its
+ * own, and the reliable and unreliable segments are sent without copying.
  *
- * A 0 size will still generate a packet and deal with the reliable messages.
+ * No segments will still generate a packet and deal with the reliable messages.
  */
-void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
-	mem_buf_t send;
-	byte send_buffer[MAX_MSG_SIZE];
+void Netchan_Transmitv(net_chan_t *chan, const net_iovec_t *segments, size_t count) {
+	net_iovec_t iov[NET_UDP_MAX_IOVECS];
+	mem_buf_t header;
+	byte header_buffer[16];
+
+	if (count > NETCHAN_MAX_SEGMENTS) {
+		Com_Error(ERROR_DROP, "Too many segments: %u\n", (uint32_t) count);
+	}
 
 	// check for message overflow
 	if (chan->message.overflowed) {
@@ -176,7 +183,7 @@ void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
 	}
 
 	// write the packet header
-	Mem_InitBuffer(&send, send_buffer, sizeof(send_buffer));
+	Mem_InitBuffer(&header, header_buffer, sizeof(header_buffer));
 
 	const uint32_t w1 = (chan->outgoing_sequence & ~(1u << 31)) | (send_reliable << 31);
 	const uint32_t w2 = (chan->incoming_sequence & ~(1u << 31)) | (chan->reliable_incoming << 31);
@@ -184,41 +191,69 @@ void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
 	chan->outgoing_sequence++;
 	chan->last_sent = quetoo.ticks;
 
-	Net_WriteLong(&send, w1);
-	Net_WriteLong(&send, w2);
+	Net_WriteLong(&header, w1);
+	Net_WriteLong(&header, w2);
 
 	// send the qport if we are a client
 	if (chan->source == NS_UDP_CLIENT) {
-		Net_WriteByte(&send, chan->qport);
+		Net_WriteByte(&header, chan->qport);
 	}
 
-	// copy the reliable message to the packet first
+	size_t num_iov = 0, size = header.size;
+	iov[num_iov++] = (net_iovec_t) { .data = header.data, .len = header.size };
+
+	// the reliable message is placed first
 	if (send_reliable) {
-		Mem_WriteBuffer(&send, chan->reliable_buffer, chan->reliable_size);
+		iov[num_iov++] = (net_iovec_t) { .data = chan->reliable_buffer, .len = chan->reliable_size };
+		size += chan->reliable_size;
+
 		chan->reliable_outgoing = chan->outgoing_sequence;
 	}
 
 	// add the unreliable part if space is available
-	if (send.max_size - send.size >= len) {
-		Mem_WriteBuffer(&send, data, len);
+	size_t len = 0;
+	for (size_t i = 0; i < count; i++) {
+		len += segments[i].len;
+	}
+
+	if (MAX_MSG_SIZE - size >= len) {
+		for (size_t i = 0; i < count; i++) {
+			if (segments[i].len) {
+				iov[num_iov++] = segments[i];
+			}
+		}
+		size += len;
 	} else {
 		Com_Warn("Netchan_Transmit: dumped unreliable\n");
 	}
 
 	// send the datagram
-	Net_SendDatagram(chan->source, &chan->remote_address, send.data, send.size);
+	Net_SendDatagramv(chan->source, &chan->remote_address, iov, num_iov);
 
 	if (net_show_packets->value) {
 		if (send_reliable)
-			Com_Print("Send %u bytes: s=%i reliable=%i ack=%i rack=%i\n", (uint32_t) send.size,
+			Com_Print("Send %u bytes: s=%i reliable=%i ack=%i rack=%i\n", (uint32_t) size,
 			          chan->outgoing_sequence - 1, chan->reliable_sequence, chan->incoming_sequence,
 			          chan->reliable_incoming);
 		else
-			Com_Print("Send %u bytes : s=%i ack=%i rack=%i\n", (uint32_t) send.size,
+			Com_Print("Send %u bytes : s=%i ack=%i rack=%i\n", (uint32_t) size,
 			          chan->outgoing_sequence - 1, chan->incoming_sequence, chan->reliable_incoming);
 	}
 }
 
+/**
+ * @brief Tries to send an unreliable message to a connection, and handles the
+ * transmission / retransmission of the reliable messages.
+ *
+ * A 0 size will still generate a packet and deal with the reliable messages.
+ */
+void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
+
+	const net_iovec_t segment = { .data = data, .len = len };
+
+	Netchan_Transmitv(chan, &segment, len ? 1 : 0);
+}
+
 /**
  * @brief Called when the current net_message is from remote_address
  * modifies net_message so that it points to the packet payload
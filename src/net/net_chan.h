@@ -24,11 +24,18 @@
 #include "net_udp.h"
 #include "net_message.h"
 
+/**
+ * @brief The maximum number of unreliable segments per Netchan_Transmitv. The
+ * packet header and reliable message occupy the remaining datagram segments.
+ */
+#define NETCHAN_MAX_SEGMENTS (NET_UDP_MAX_IOVECS - 2)
+
 extern net_addr_t net_from;
 extern mem_buf_t net_message;
 
 void Netchan_Setup(net_src_t source, net_chan_t *chan, net_addr_t *addr, uint8_t qport);
 void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len);
+void Netchan_Transmitv(net_chan_t *chan, const net_iovec_t *segments, size_t count);
 void Netchan_OutOfBand(int32_t sock, const net_addr_t *addr, const void *data, size_t len);
 void Netchan_OutOfBandPrint(int32_t sock, const net_addr_t *addr, const char *format, ...) __attribute__((format(printf,
         3, 4)));
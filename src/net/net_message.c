@@ -143,6 +143,176 @@ void Net_WriteDir(mem_buf_t *msg, const vec3_t dir) {
 	Net_WriteByte(msg, best);
 }
 
+/**
+ * @brief Prepares a bit cursor for writing to or reading from the message.
+ */
+void Net_BeginBits(mem_buf_t *msg, net_bits_t *bits) {
+
+	bits->msg = msg;
+	bits->bits = 0;
+	bits->count = 0;
+}
+
+/**
+ * @brief Writes the low `count` bits of `value`, where `count` is at most 32.
+ */
+void Net_WriteBits(net_bits_t *bits, const uint32_t value, const uint32_t count) {
+
+	const uint64_t mask = (1ull << count) - 1;
+
+	bits->bits |= (value & mask) << bits->count;
+	bits->count += count;
+
+	while (bits->count >= 8) {
+		Net_WriteByte(bits->msg, (int32_t) (bits->bits & 0xff));
+		bits->bits >>= 8;
+		bits->count -= 8;
+	}
+}
+
+/**
+ * @brief Writes `value` in `count` bits, two's complement.
+ */
+void Net_WriteSignedBits(net_bits_t *bits, const int32_t value, const uint32_t count) {
+	Net_WriteBits(bits, (uint32_t) value, count);
+}
+
+/**
+ * @brief Pads any partially written byte, so that the message may be written to
+ * directly again.
+ */
+void Net_FlushBits(net_bits_t *bits) {
+
+	if (bits->count) {
+		Net_WriteByte(bits->msg, (int32_t) (bits->bits & 0xff));
+	}
+
+	bits->bits = 0;
+	bits->count = 0;
+}
+
+/**
+ * @brief Writes an unsigned integer in as few bytes as possible, 7 bits per byte.
+ * This is used for field masks, which are usually sparse in their high bits.
+ */
+void Net_WriteVarint(mem_buf_t *msg, uint32_t value) {
+
+	while (value >= 0x80) {
+		Net_WriteByte(msg, (int32_t) ((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+
+	Net_WriteByte(msg, (int32_t) value);
+}
+
+/**
+ * @brief Positions are quantized to 1/8 unit for PROTOCOL_MAJOR.
+ */
+#define NET_POSITION_SCALE 8.0
+
+#define NET_POSITION_RELATIVE_BITS 12
+#define NET_POSITION_ABSOLUTE_BITS 20
+
+/**
+ * @brief Position encodings for PROTOCOL_MAJOR, written in 2 bits.
+ */
+typedef enum {
+	NET_POSITION_RELATIVE, // quantized difference from the previous position
+	NET_POSITION_ABSOLUTE, // quantized position
+	NET_POSITION_EXACT // unquantized, for positions outside of the quantized range
+} net_position_t;
+
+/**
+ * @brief Quantizes the vector, returning false if it can not be represented in
+ * NET_POSITION_ABSOLUTE_BITS.
+ */
+static _Bool Net_QuantizePosition(const vec3_t v, int32_t *q) {
+
+	const double limit = 1 << (NET_POSITION_ABSOLUTE_BITS - 1);
+
+	for (int32_t i = 0; i < 3; i++) {
+		const double d = floor(v[i] * NET_POSITION_SCALE + 0.5);
+
+		if (!(d >= -limit && d < limit)) { // also catches NaN
+			return false;
+		}
+
+		q[i] = (int32_t) d;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Writes the position `to`, relative to `from` where possible. Because
+ * quantized positions decode exactly, the reader's copy of `from` quantizes
+ * identically, and deltas do not drift.
+ */
+static void Net_WriteDeltaPosition(mem_buf_t *msg, const vec3_t from, const vec3_t to, const int32_t protocol) {
+
+	if (protocol == PROTOCOL_MAJOR_LEGACY) {
+		Net_WritePosition(msg, to);
+		return;
+	}
+
+	int32_t qf[3], qt[3];
+	net_bits_t bits;
+
+	Net_BeginBits(msg, &bits);
+
+	if (Net_QuantizePosition(to, qt)) {
+		_Bool relative = Net_QuantizePosition(from, qf);
+
+		const int32_t limit = 1 << (NET_POSITION_RELATIVE_BITS - 1);
+
+		for (int32_t i = 0; i < 3 && relative; i++) {
+			const int32_t d = qt[i] - qf[i];
+			relative = d >= -limit && d < limit;
+		}
+
+		if (relative) {
+			Net_WriteBits(&bits, NET_POSITION_RELATIVE, 2);
+			for (int32_t i = 0; i < 3; i++) {
+				Net_WriteSignedBits(&bits, qt[i] - qf[i], NET_POSITION_RELATIVE_BITS);
+			}
+		} else {
+			Net_WriteBits(&bits, NET_POSITION_ABSOLUTE, 2);
+			for (int32_t i = 0; i < 3; i++) {
+				Net_WriteSignedBits(&bits, qt[i], NET_POSITION_ABSOLUTE_BITS);
+			}
+		}
+	} else {
+		Net_WriteBits(&bits, NET_POSITION_EXACT, 2);
+		for (int32_t i = 0; i < 3; i++) {
+			const net_vec_t vec = {
+				.v = to[i]
+			};
+			Net_WriteBits(&bits, (uint32_t) vec.i, 32);
+		}
+	}
+
+	Net_FlushBits(&bits);
+}
+
+/**
+ * @brief Writes an entity or player state field mask.
+ */
+static void Net_WriteDeltaBits(mem_buf_t *msg, const uint32_t bits, const int32_t protocol) {
+
+	if (protocol == PROTOCOL_MAJOR_LEGACY) {
+		Net_WriteShort(msg, (int32_t) bits);
+	} else {
+		Net_WriteVarint(msg, bits);
+	}
+}
+
+/**
+ * @brief Writes the field mask of an entity delta, following its number.
+ */
+void Net_WriteDeltaEntityBits(mem_buf_t *msg, const uint16_t bits, const int32_t protocol) {
+	Net_WriteDeltaBits(msg, bits, protocol);
+}
+
 /**
  * @brief
  */
@@ -206,7 +376,8 @@ void Net_WriteDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, const pm_cmd_t
 /**
  * @brief
  */
-void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to) {
+void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to,
+                               const int32_t protocol) {
 
 	uint16_t bits = 0;
 
@@ -254,18 +425,18 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
 		bits |= PS_PM_HOOK_LENGTH;
 	}
 
-	Net_WriteShort(msg, bits);
+	Net_WriteDeltaBits(msg, bits, protocol);
 
 	if (bits & PS_PM_TYPE) {
 		Net_WriteByte(msg, to->pm_state.type);
 	}
 
 	if (bits & PS_PM_ORIGIN) {
-		Net_WritePosition(msg, to->pm_state.origin);
+		Net_WriteDeltaPosition(msg, from->pm_state.origin, to->pm_state.origin, protocol);
 	}
 
 	if (bits & PS_PM_VELOCITY) {
-		Net_WritePosition(msg, to->pm_state.velocity);
+		Net_WriteDeltaPosition(msg, from->pm_state.velocity, to->pm_state.velocity, protocol);
 	}
 
 	if (bits & PS_PM_FLAGS) {
@@ -299,7 +470,7 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
 	}
 
 	if (bits & PS_PM_HOOK_POSITION) {
-		Net_WritePosition(msg, to->pm_state.hook_position);
+		Net_WriteDeltaPosition(msg, from->pm_state.hook_position, to->pm_state.hook_position, protocol);
 	}
 
 	if (bits & PS_PM_HOOK_LENGTH) {
@@ -314,7 +485,11 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
 		}
 	}
 
-	Net_WriteLong(msg, stat_bits);
+	if (protocol == PROTOCOL_MAJOR_LEGACY) {
+		Net_WriteLong(msg, stat_bits);
+	} else {
+		Net_WriteVarint(msg, stat_bits);
+	}
 
 	for (int32_t i = 0; i < MAX_STATS; i++) {
 		if (stat_bits & (1 << i)) {
@@ -328,7 +503,7 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
  * either a baseline or a previous packet_entity
  */
 void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to,
-                          _Bool force) {
+                          _Bool force, const int32_t protocol) {
 
 	uint16_t bits = 0;
 
@@ -396,14 +571,14 @@ void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const enti
 	// write the message
 
 	Net_WriteShort(msg, to->number);
-	Net_WriteShort(msg, bits);
+	Net_WriteDeltaEntityBits(msg, bits, protocol);
 
 	if (bits & U_ORIGIN) {
-		Net_WritePosition(msg, to->origin);
+		Net_WriteDeltaPosition(msg, from->origin, to->origin, protocol);
 	}
 
 	if (bits & U_TERMINATION) {
-		Net_WritePosition(msg, to->termination);
+		Net_WriteDeltaPosition(msg, from->termination, to->termination, protocol);
 	}
 
 	if (bits & U_ANGLES) {
@@ -628,6 +803,124 @@ void Net_ReadDir(mem_buf_t *msg, vec3_t dir) {
 	VectorCopy(approximate_normals[b], dir);
 }
 
+/**
+ * @brief Reads `count` bits, where `count` is at most 32.
+ */
+uint32_t Net_ReadBits(net_bits_t *bits, const uint32_t count) {
+
+	while (bits->count < count) {
+		bits->bits |= ((uint64_t) (Net_ReadByte(bits->msg) & 0xff)) << bits->count;
+		bits->count += 8;
+	}
+
+	const uint64_t mask = (1ull << count) - 1;
+	const uint32_t value = (uint32_t) (bits->bits & mask);
+
+	bits->bits >>= count;
+	bits->count -= count;
+
+	return value;
+}
+
+/**
+ * @brief Reads a two's complement value of `count` bits.
+ */
+int32_t Net_ReadSignedBits(net_bits_t *bits, const uint32_t count) {
+
+	const uint32_t value = Net_ReadBits(bits, count);
+	const uint32_t sign = 1u << (count - 1);
+
+	return (int32_t) ((value ^ sign) - sign);
+}
+
+/**
+ * @brief Reads an unsigned integer written by Net_WriteVarint.
+ */
+uint32_t Net_ReadVarint(mem_buf_t *msg) {
+	uint32_t value = 0;
+
+	for (uint32_t shift = 0; shift < 35; shift += 7) {
+		const int32_t c = Net_ReadByte(msg);
+
+		value |= ((uint32_t) c & 0x7f) << shift;
+
+		if (c == -1 || !(c & 0x80)) {
+			break;
+		}
+	}
+
+	return value;
+}
+
+/**
+ * @brief Reads a position written by Net_WriteDeltaPosition.
+ */
+static void Net_ReadDeltaPosition(mem_buf_t *msg, const vec3_t from, vec3_t to, const int32_t protocol) {
+
+	if (protocol == PROTOCOL_MAJOR_LEGACY) {
+		Net_ReadPosition(msg, to);
+		return;
+	}
+
+	net_bits_t bits;
+	Net_BeginBits(msg, &bits);
+
+	const net_position_t type = Net_ReadBits(&bits, 2);
+
+	switch (type) {
+		case NET_POSITION_RELATIVE: {
+				int32_t qf[3];
+
+				if (!Net_QuantizePosition(from, qf)) {
+					Com_Error(ERROR_DROP, "Relative position from %s\n", vtos(from));
+				}
+
+				for (int32_t i = 0; i < 3; i++) {
+					const int32_t d = Net_ReadSignedBits(&bits, NET_POSITION_RELATIVE_BITS);
+					to[i] = (qf[i] + d) / NET_POSITION_SCALE;
+				}
+			}
+			break;
+
+		case NET_POSITION_ABSOLUTE:
+			for (int32_t i = 0; i < 3; i++) {
+				to[i] = Net_ReadSignedBits(&bits, NET_POSITION_ABSOLUTE_BITS) / NET_POSITION_SCALE;
+			}
+			break;
+
+		case NET_POSITION_EXACT:
+			for (int32_t i = 0; i < 3; i++) {
+				const net_vec_t vec = {
+					.i = (int32_t) Net_ReadBits(&bits, 32)
+				};
+				to[i] = vec.v;
+			}
+			break;
+
+		default:
+			Com_Error(ERROR_DROP, "Bad position type: %d\n", type);
+	}
+}
+
+/**
+ * @brief Reads an entity or player state field mask.
+ */
+static uint32_t Net_ReadDeltaBits(mem_buf_t *msg, const int32_t protocol) {
+
+	if (protocol == PROTOCOL_MAJOR_LEGACY) {
+		return (uint16_t) Net_ReadShort(msg);
+	} else {
+		return Net_ReadVarint(msg);
+	}
+}
+
+/**
+ * @brief Reads the field mask of an entity delta, following its number.
+ */
+uint16_t Net_ReadDeltaEntityBits(mem_buf_t *msg, const int32_t protocol) {
+	return (uint16_t) Net_ReadDeltaBits(msg, protocol);
+}
+
 /**
  * @brief
  */
@@ -667,22 +960,23 @@ void Net_ReadDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, pm_cmd_t *to) {
 /**
  * @brief
  */
-void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to) {
+void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to,
+                              const int32_t protocol) {
 
 	*to = *from;
 
-	const int32_t bits = Net_ReadShort(msg);
+	const uint32_t bits = Net_ReadDeltaBits(msg, protocol);
 
 	if (bits & PS_PM_TYPE) {
 		to->pm_state.type = Net_ReadByte(msg);
 	}
 
 	if (bits & PS_PM_ORIGIN) {
-		Net_ReadPosition(msg, to->pm_state.origin);
+		Net_ReadDeltaPosition(msg, from->pm_state.origin, to->pm_state.origin, protocol);
 	}
 
 	if (bits & PS_PM_VELOCITY) {
-		Net_ReadPosition(msg, to->pm_state.velocity);
+		Net_ReadDeltaPosition(msg, from->pm_state.velocity, to->pm_state.velocity, protocol);
 	}
 
 	if (bits & PS_PM_FLAGS) {
@@ -716,14 +1010,19 @@ void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player
 	}
 
 	if (bits & PS_PM_HOOK_POSITION) {
-		Net_ReadPosition(msg, to->pm_state.hook_position);
+		Net_ReadDeltaPosition(msg, from->pm_state.hook_position, to->pm_state.hook_position, protocol);
 	}
 
 	if (bits & PS_PM_HOOK_LENGTH) {
 		to->pm_state.hook_length = Net_ReadShort(msg);
 	}
 
-	const int32_t stat_bits = Net_ReadLong(msg);
+	uint32_t stat_bits;
+	if (protocol == PROTOCOL_MAJOR_LEGACY) {
+		stat_bits = (uint32_t) Net_ReadLong(msg);
+	} else {
+		stat_bits = Net_ReadVarint(msg);
+	}
 
 	for (int32_t i = 0; i < MAX_STATS; i++) {
 		if (stat_bits & (1 << i)) {
@@ -736,18 +1035,18 @@ void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player
  * @brief
  */
 void Net_ReadDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_state_t *to,
-                         uint16_t number, uint16_t bits) {
+                         uint16_t number, uint16_t bits, const int32_t protocol) {
 
 	*to = *from;
 
 	to->number = number;
 
 	if (bits & U_ORIGIN) {
-		Net_ReadPosition(msg, to->origin);
+		Net_ReadDeltaPosition(msg, from->origin, to->origin, protocol);
 	}
 
 	if (bits & U_TERMINATION) {
-		Net_ReadPosition(msg, to->termination);
+		Net_ReadDeltaPosition(msg, from->termination, to->termination, protocol);
 	}
 
 	if (bits & U_ANGLES) {
@@ -75,6 +75,18 @@
 #define S_ENTITY				(1 << 2)
 #define S_PITCH					(1 << 3)
 
+/**
+ * @brief A cursor for writing or reading individual bits of a message. Bits are
+ * packed least significant first. Writes must be padded to a whole byte with
+ * Net_FlushBits before writing to the message directly again. Reads consume
+ * whole bytes as needed.
+ */
+typedef struct {
+	mem_buf_t *msg;
+	uint64_t bits;
+	uint32_t count;
+} net_bits_t;
+
 /**
  * @brief Message writing and reading facilities.
  */
@@ -89,9 +101,17 @@ void Net_WritePosition(mem_buf_t *msg, const vec3_t pos);
 void Net_WriteAngle(mem_buf_t *msg, const vec_t f);
 void Net_WriteAngles(mem_buf_t *msg, const vec3_t angles);
 void Net_WriteDir(mem_buf_t *msg, const vec3_t dir);
+void Net_BeginBits(mem_buf_t *msg, net_bits_t *bits);
+void Net_WriteBits(net_bits_t *bits, const uint32_t value, const uint32_t count);
+void Net_WriteSignedBits(net_bits_t *bits, const int32_t value, const uint32_t count);
+void Net_FlushBits(net_bits_t *bits);
+void Net_WriteVarint(mem_buf_t *msg, uint32_t value);
 void Net_WriteDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, const pm_cmd_t *to);
-void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to);
-void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to, _Bool force);
+void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to,
+                               const int32_t protocol);
+void Net_WriteDeltaEntityBits(mem_buf_t *msg, const uint16_t bits, const int32_t protocol);
+void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to, _Bool force,
+                          const int32_t protocol);
 
 void Net_BeginReading(mem_buf_t *msg);
 void Net_ReadData(mem_buf_t *msg, void *data, size_t len);
@@ -106,7 +126,12 @@ void Net_ReadPosition(mem_buf_t *msg, vec3_t pos);
 vec_t Net_ReadAngle(mem_buf_t *msg);
 void Net_ReadAngles(mem_buf_t *msg, vec3_t angles);
 void Net_ReadDir(mem_buf_t *msg, vec3_t vector);
+uint32_t Net_ReadBits(net_bits_t *bits, const uint32_t count);
+int32_t Net_ReadSignedBits(net_bits_t *bits, const uint32_t count);
+uint32_t Net_ReadVarint(mem_buf_t *msg);
 void Net_ReadDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, pm_cmd_t *to);
-void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to);
+void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to,
+                              const int32_t protocol);
+uint16_t Net_ReadDeltaEntityBits(mem_buf_t *msg, const int32_t protocol);
 void Net_ReadDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_state_t *to,
-                         uint16_t number, uint16_t bits);
+                         uint16_t number, uint16_t bits, const int32_t protocol);
@@ -19,18 +19,37 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	#define _GNU_SOURCE // for recvmmsg and sendmmsg
+#endif
+
 #if defined(_WIN32)
 	#include <winsock2.h>
 	#include <ws2tcpip.h>
 #elif !defined(_MSC_VER)
 	#include <sys/time.h>
+	#include <sys/uio.h>
 #endif
 
 #include "cvar.h"
 #include "net_udp.h"
 
+#if defined(MSG_WAITFORONE)
+	#define NET_UDP_MMSG 1 // recvmmsg and sendmmsg are available
+#endif
+
 #define MAX_NET_UDP_LOOPS 64
 
+/**
+ * @brief The maximum number of datagrams received or sent per system call.
+ */
+#define NET_UDP_BATCH 32
+
+/**
+ * @brief The maximum size of datagrams queued for sending.
+ */
+#define NET_UDP_BATCH_SIZE (MAX_MSG_SIZE * 4)
+
 typedef struct {
 	byte data[MAX_MSG_SIZE];
 	size_t size;
@@ -42,13 +61,39 @@ typedef struct {
 	int32_t send, recv;
 } net_udp_loop_t;
 
+typedef struct {
+	net_addr_t to;
+	net_sockaddr addr;
+	size_t offset, len;
+} net_udp_datagram_t;
+
+/**
+ * @brief Datagrams are received several at a time, and queued for sending
+ * between Net_BeginDatagrams and Net_FlushDatagrams, to reduce system calls.
+ */
+typedef struct {
+	byte *recv_data; // NET_UDP_BATCH buffers of MAX_MSG_SIZE
+	net_udp_datagram_t recv[NET_UDP_BATCH];
+	int32_t num_recv, recv_index;
+
+	_Bool queue; // between Net_BeginDatagrams and Net_FlushDatagrams
+	byte send_data[NET_UDP_BATCH_SIZE];
+	net_udp_datagram_t send[NET_UDP_BATCH];
+	int32_t num_send;
+	size_t send_size;
+
+	net_udp_stats_t stats;
+} net_udp_batch_t;
+
 typedef struct {
 	net_udp_loop_t loops[2];
 	int32_t sockets[2];
+	net_udp_batch_t batches[2];
 } net_udp_state_t;
 
 static net_udp_state_t net_udp_state;
 
+static cvar_t *net_batch;
 static cvar_t *net_loop_latency;
 static cvar_t *net_loop_jitter;
 static cvar_t *net_loop_loss;
@@ -96,6 +141,77 @@ static _Bool Net_ReceiveDatagram_Loop(net_src_t source, net_addr_t *from, mem_bu
 	return true;
 }
 
+#if defined(NET_UDP_MMSG)
+/**
+ * @brief Returns the next pending datagram for the specified socket, first
+ * receiving as many as NET_UDP_BATCH with a single system call if necessary.
+ */
+static _Bool Net_ReceiveDatagram_Batch(net_src_t source, net_addr_t *from, mem_buf_t *buf) {
+	net_udp_batch_t *batch = &net_udp_state.batches[source];
+
+	if (batch->recv_index == batch->num_recv) {
+		struct mmsghdr msgs[NET_UDP_BATCH];
+		struct iovec iov[NET_UDP_BATCH];
+
+		if (!batch->recv_data) {
+			batch->recv_data = Mem_Malloc(NET_UDP_BATCH * MAX_MSG_SIZE);
+		}
+
+		memset(msgs, 0, sizeof(msgs));
+
+		for (int32_t i = 0; i < NET_UDP_BATCH; i++) {
+			iov[i].iov_base = batch->recv_data + i * MAX_MSG_SIZE;
+			iov[i].iov_len = MAX_MSG_SIZE;
+
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_hdr.msg_name = &batch->recv[i].addr;
+			msgs[i].msg_hdr.msg_namelen = sizeof(net_sockaddr);
+		}
+
+		batch->recv_index = batch->num_recv = 0;
+
+		const int32_t received = recvmmsg(net_udp_state.sockets[source], msgs, NET_UDP_BATCH, 0, NULL);
+
+		batch->stats.receive_calls++;
+
+		if (received == -1) {
+			const int32_t err = Net_GetError();
+
+			if (err == EWOULDBLOCK || err == ECONNREFUSED) {
+				return false;    // not terribly abnormal
+			}
+
+			Com_Warn("%s\n", Net_GetErrorString());
+			return false;
+		}
+
+		for (int32_t i = 0; i < received; i++) {
+			batch->recv[i].offset = i * MAX_MSG_SIZE;
+			batch->recv[i].len = msgs[i].msg_len;
+		}
+
+		batch->num_recv = received;
+		batch->stats.packets_received += received;
+	}
+
+	const net_udp_datagram_t *datagram = &batch->recv[batch->recv_index++];
+
+	from->addr = datagram->addr.sin_addr.s_addr;
+	from->port = datagram->addr.sin_port;
+
+	if (datagram->len >= buf->max_size) {
+		Com_Warn("Oversized packet from %s\n", Net_NetaddrToString(from));
+		return false;
+	}
+
+	memcpy(buf->data, batch->recv_data + datagram->offset, datagram->len);
+	buf->size = datagram->len;
+
+	return true;
+}
+#endif
+
 /**
  * @brief Receive a datagram on the specified socket, populating the from
  * address with the sender.
@@ -117,12 +233,22 @@ _Bool Net_ReceiveDatagram(net_src_t source, net_addr_t *from, mem_buf_t *buf) {
 		return false;
 	}
 
+#if defined(NET_UDP_MMSG)
+	if (net_batch->integer) {
+		return Net_ReceiveDatagram_Batch(source, from, buf);
+	}
+#endif
+
+	net_udp_stats_t *stats = &net_udp_state.batches[source].stats;
+
 	net_sockaddr addr;
 	socklen_t addr_len = sizeof(addr);
 
 	const ssize_t received = recvfrom(sock, (void *) buf->data, buf->max_size, 0,
 	                                  (struct sockaddr *) &addr, &addr_len);
 
+	stats->receive_calls++;
+
 	from->addr = addr.sin_addr.s_addr;
 	from->port = addr.sin_port;
 
@@ -137,6 +263,8 @@ _Bool Net_ReceiveDatagram(net_src_t source, net_addr_t *from, mem_buf_t *buf) {
 		return false;
 	}
 
+	stats->packets_received++;
+
 	from->addr = addr.sin_addr.s_addr;
 	from->port = addr.sin_port;
 
@@ -150,16 +278,32 @@ _Bool Net_ReceiveDatagram(net_src_t source, net_addr_t *from, mem_buf_t *buf) {
 	return true;
 }
 
+/**
+ * @brief Copies the given segments, contiguously, to the specified buffer.
+ */
+static void Net_GatherDatagram(byte *out, const net_iovec_t *iov, size_t count) {
+
+	for (size_t i = 0; i < count; i++) {
+		memcpy(out, iov[i].data, iov[i].len);
+		out += iov[i].len;
+	}
+}
+
 /**
  * @brief
  */
-static _Bool Net_SendDatagram_Loop(net_src_t source, const void *data, size_t len) {
+static _Bool Net_SendDatagram_Loop(net_src_t source, const net_iovec_t *iov, size_t count, size_t len) {
 	net_udp_loop_t *loop = &net_udp_state.loops[source ^ 1];
 
+	if (len > sizeof(loop->messages[0].data)) {
+		Com_Warn("Oversized loop packet\n");
+		return false;
+	}
+
 	const uint32_t i = loop->send & (MAX_NET_UDP_LOOPS - 1);
 	loop->send++;
 
-	memcpy(loop->messages[i].data, data, len);
+	Net_GatherDatagram(loop->messages[i].data, iov, count);
 	loop->messages[i].size = len;
 	loop->messages[i].timestamp = quetoo.ticks;
 
@@ -167,12 +311,87 @@ static _Bool Net_SendDatagram_Loop(net_src_t source, const void *data, size_t le
 }
 
 /**
- * @brief Send a datagram to the specified address.
+ * @brief Sends all queued datagrams for the specified source, using as few
+ * system calls as possible.
  */
-_Bool Net_SendDatagram(net_src_t source, const net_addr_t *to, const void *data, size_t len) {
+static void Net_SendDatagrams(net_src_t source) {
+	net_udp_batch_t *batch = &net_udp_state.batches[source];
+
+	const int32_t sock = net_udp_state.sockets[source];
+
+	if (sock && batch->num_send) {
+
+#if defined(NET_UDP_MMSG)
+		struct mmsghdr msgs[NET_UDP_BATCH];
+		struct iovec iov[NET_UDP_BATCH];
+
+		memset(msgs, 0, sizeof(msgs));
+
+		for (int32_t i = 0; i < batch->num_send; i++) {
+			net_udp_datagram_t *datagram = &batch->send[i];
+
+			iov[i].iov_base = batch->send_data + datagram->offset;
+			iov[i].iov_len = datagram->len;
+
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_hdr.msg_name = &datagram->addr;
+			msgs[i].msg_hdr.msg_namelen = sizeof(net_sockaddr);
+		}
+
+		for (int32_t i = 0; i < batch->num_send;) {
+
+			const int32_t sent = sendmmsg(sock, msgs + i, batch->num_send - i, 0);
+
+			batch->stats.send_calls++;
+
+			if (sent == -1) { // skip the offending datagram and carry on
+				Com_Warn("%s to %s\n", Net_GetErrorString(), Net_NetaddrToString(&batch->send[i].to));
+				i++;
+			} else {
+				batch->stats.packets_sent += sent;
+				i += sent;
+			}
+		}
+#else
+		for (int32_t i = 0; i < batch->num_send; i++) {
+			const net_udp_datagram_t *datagram = &batch->send[i];
+
+			const ssize_t sent = sendto(sock, (const void *) (batch->send_data + datagram->offset), datagram->len, 0,
+			                            (const struct sockaddr *) &datagram->addr, sizeof(datagram->addr));
+
+			batch->stats.send_calls++;
+
+			if (sent == -1) {
+				Com_Warn("%s to %s\n", Net_GetErrorString(), Net_NetaddrToString(&datagram->to));
+			} else {
+				batch->stats.packets_sent++;
+			}
+		}
+#endif
+	}
+
+	batch->num_send = 0;
+	batch->send_size = 0;
+}
+
+/**
+ * @brief Send a datagram, gathered from the given segments, to the specified
+ * address. The segments are not copied unless the datagram must be queued.
+ */
+_Bool Net_SendDatagramv(net_src_t source, const net_addr_t *to, const net_iovec_t *iov, size_t count) {
+
+	if (count > NET_UDP_MAX_IOVECS) {
+		Com_Error(ERROR_DROP, "Too many segments: %u\n", (uint32_t) count);
+	}
+
+	size_t len = 0;
+	for (size_t i = 0; i < count; i++) {
+		len += iov[i].len;
+	}
 
 	if (to->type == NA_LOOP) {
-		return Net_SendDatagram_Loop(source, data, len);
+		return Net_SendDatagram_Loop(source, iov, count, len);
 	}
 
 	int32_t sock;
@@ -184,19 +403,109 @@ _Bool Net_SendDatagram(net_src_t source, const net_addr_t *to, const void *data,
 		Com_Error(ERROR_DROP, "Bad address type\n");
 	}
 
+	net_udp_batch_t *batch = &net_udp_state.batches[source];
+
 	net_sockaddr to_addr;
 	Net_NetAddrToSockaddr(to, &to_addr);
 
-	ssize_t sent = sendto(sock, data, len, 0, (const struct sockaddr *) &to_addr, sizeof(to_addr));
+	if (batch->queue && len <= sizeof(batch->send_data)) {
+
+		if (batch->num_send == NET_UDP_BATCH || batch->send_size + len > sizeof(batch->send_data)) {
+			Net_SendDatagrams(source);
+		}
+
+		net_udp_datagram_t *datagram = &batch->send[batch->num_send++];
+
+		datagram->to = *to;
+		datagram->addr = to_addr;
+		datagram->offset = batch->send_size;
+		datagram->len = len;
+
+		Net_GatherDatagram(batch->send_data + batch->send_size, iov, count);
+		batch->send_size += len;
+
+		return true;
+	}
+
+#if defined(_WIN32)
+	byte data[MAX_MSG_SIZE];
+
+	if (len > sizeof(data)) {
+		Com_Warn("Oversized packet to %s\n", Net_NetaddrToString(to));
+		return false;
+	}
+
+	Net_GatherDatagram(data, iov, count);
+
+	const ssize_t sent = sendto(sock, (const char *) data, (int32_t) len, 0, (const struct sockaddr *) &to_addr, sizeof(to_addr));
+#else
+	struct iovec vec[NET_UDP_MAX_IOVECS];
+
+	for (size_t i = 0; i < count; i++) {
+		vec[i].iov_base = (void *) iov[i].data;
+		vec[i].iov_len = iov[i].len;
+	}
+
+	const struct msghdr msg = {
+		.msg_name = &to_addr,
+		.msg_namelen = sizeof(to_addr),
+		.msg_iov = vec,
+		.msg_iovlen = count
+	};
+
+	const ssize_t sent = sendmsg(sock, &msg, 0);
+#endif
+
+	batch->stats.send_calls++;
 
 	if (sent == -1) {
 		Com_Warn("%s to %s\n", Net_GetErrorString(), Net_NetaddrToString(to));
 		return false;
 	}
 
+	batch->stats.packets_sent++;
+
 	return true;
 }
 
+/**
+ * @brief Send a datagram to the specified address.
+ */
+_Bool Net_SendDatagram(net_src_t source, const net_addr_t *to, const void *data, size_t len) {
+
+	const net_iovec_t iov = { .data = data, .len = len };
+
+	return Net_SendDatagramv(source, to, &iov, 1);
+}
+
+/**
+ * @brief Queues datagrams sent to network addresses from the specified source
+ * until Net_FlushDatagrams is called, so that they may be sent together.
+ */
+void Net_BeginDatagrams(net_src_t source) {
+
+	Net_SendDatagrams(source);
+
+	net_udp_state.batches[source].queue = net_batch->integer;
+}
+
+/**
+ * @brief Sends any queued datagrams, and stops queueing them.
+ */
+void Net_FlushDatagrams(net_src_t source) {
+
+	Net_SendDatagrams(source);
+
+	net_udp_state.batches[source].queue = false;
+}
+
+/**
+ * @return The datagram counters for the specified source.
+ */
+net_udp_stats_t *Net_DatagramStats(net_src_t source) {
+	return &net_udp_state.batches[source].stats;
+}
+
 /**
  * @brief Sleeps for msec or until the server socket is ready.
  */
@@ -207,6 +516,11 @@ void Net_Sleep(uint32_t msec) {
 	const uint32_t sock = net_udp_state.sockets[NS_UDP_SERVER];
 	assert(sock);
 
+	const net_udp_batch_t *batch = &net_udp_state.batches[NS_UDP_SERVER];
+	if (batch->recv_index < batch->num_recv) { // datagrams are already pending
+		return;
+	}
+
 	FD_ZERO(&fdset);
 	FD_SET(sock, &fdset); // server socket
 
@@ -226,6 +540,9 @@ void Net_Config(net_src_t source, _Bool up) {
 
 	if (up) {
 
+		net_batch = Cvar_Add("net_batch", "1", 0,
+				"Receive and send multiple datagrams per system call, where supported");
+
 		net_loop_latency = Cvar_Add("net_loop_latency", "0", CVAR_DEVELOPER,
 				"Simulate network latency, in milliseconds, on localhost (developer tool)");
 
@@ -246,8 +563,18 @@ void Net_Config(net_src_t source, _Bool up) {
 		}
 	} else {
 		if (*sock != 0) {
+			Net_FlushDatagrams(source);
+
 			Net_CloseSocket(*sock);
 			*sock = 0;
 		}
+
+		net_udp_batch_t *batch = &net_udp_state.batches[source];
+
+		if (batch->recv_data) {
+			Mem_Free(batch->recv_data);
+		}
+
+		memset(batch, 0, sizeof(*batch));
 	}
 }
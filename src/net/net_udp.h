@@ -23,8 +23,35 @@
 
 #include "net.h"
 
+/**
+ * @brief Datagram and system call counters, for measuring batching.
+ */
+typedef struct {
+	uint32_t packets_received;
+	uint32_t receive_calls;
+	uint32_t packets_sent;
+	uint32_t send_calls;
+} net_udp_stats_t;
+
+/**
+ * @brief The maximum number of segments that may be gathered into a datagram.
+ */
+#define NET_UDP_MAX_IOVECS 16
+
+/**
+ * @brief A datagram segment, for scatter/gather sends.
+ */
+typedef struct {
+	const void *data;
+	size_t len;
+} net_iovec_t;
+
 _Bool Net_ReceiveDatagram(net_src_t source, net_addr_t *from, mem_buf_t *buf);
 _Bool Net_SendDatagram(net_src_t source, const net_addr_t *to, const void *data, size_t len);
+_Bool Net_SendDatagramv(net_src_t source, const net_addr_t *to, const net_iovec_t *iov, size_t count);
+void Net_BeginDatagrams(net_src_t source);
+void Net_FlushDatagrams(net_src_t source);
+net_udp_stats_t *Net_DatagramStats(net_src_t source);
 
 void Net_Config(net_src_t source, _Bool up);
 void Net_Sleep(uint32_t msec);
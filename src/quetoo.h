@@ -217,6 +217,24 @@ typedef enum {
 	MEM_TAG_ALL = -1
 } mem_tag_t;
 
+/**
+ * @brief Jobs are functions run by the thread pool.
+ */
+typedef void (*ThreadRunFunc)(void *data);
+
+/**
+ * @brief Parallel-for jobs are run over a range of indices, [start, end).
+ */
+typedef void (*ThreadRangeFunc)(size_t start, size_t end, void *data);
+
+/**
+ * @brief Job counters track the completion of the jobs submitted with them,
+ * and may be waited on. Counters must be zeroed before use.
+ */
+typedef struct {
+	volatile gint pending;
+} thread_counter_t;
+
 /**
  * @brief The server, game and player movement frame rate.
  */
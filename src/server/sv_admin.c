@@ -23,6 +23,8 @@
 	#include <winsock2.h> // for htons
 #endif
 
+#include <SDL_timer.h>
+
 #include "sv_local.h"
 
 /**
@@ -391,6 +393,168 @@ static void Sv_Stuff_f(void) {
 	Net_WriteString(&sv_client->net_chan.message, va("%s\n", text));
 }
 
+/**
+ * @brief Prints the average cost of sending client packets per tick, grouped
+ * by the number of clients that were sent a frame. Useful for comparing the
+ * serial and parallel (`sv_threads`) send paths.
+ */
+static void Sv_SendStats_f(void) {
+
+	if (Cmd_Argc() > 1 && !g_strcmp0(Cmd_Argv(1), "clear")) {
+		memset(svs.send_stats, 0, sizeof(svs.send_stats));
+		return;
+	}
+
+	const double frequency = SDL_GetPerformanceFrequency();
+
+	Com_Print("Clients    Ticks    Avg ms/tick  Avg ms/client (sv_threads %d, %u threads)\n",
+	          sv_threads->integer, Thread_Count());
+
+	for (size_t i = 0; i < lengthof(svs.send_stats); i++) {
+		const sv_send_stats_t *stats = &svs.send_stats[i];
+
+		if (stats->ticks == 0) {
+			continue;
+		}
+
+		const double ms = 1000.0 * stats->time / frequency / stats->ticks;
+
+		Com_Print("%7u %8u %14.3f %14.3f\n", (uint32_t) i, stats->ticks, ms, i ? ms / i : 0.0);
+	}
+}
+
+/**
+ * @brief Prints the hit rate of the client visibility cache for the current level.
+ */
+static void Sv_VisStats_f(void) {
+
+	if (!svs.initialized) {
+		Com_Print("No server running\n");
+		return;
+	}
+
+	sv_vis_cache_t *cache = &sv.vis_cache;
+
+	if (Cmd_Argc() > 1 && !g_strcmp0(Cmd_Argv(1), "clear")) {
+		cache->set_hits = cache->set_misses = 0;
+		cache->row_hits = cache->row_misses = 0;
+		return;
+	}
+
+	const uint32_t sets = cache->set_hits + cache->set_misses;
+	const uint32_t rows = cache->row_hits + cache->row_misses;
+
+	Com_Print("Cluster sets: %u hits, %u misses (%.1f%%)\n", cache->set_hits, cache->set_misses,
+	          sets ? 100.0 * cache->set_hits / sets : 0.0);
+	Com_Print("Cluster rows: %u hits, %u misses (%.1f%%)\n", cache->row_hits, cache->row_misses,
+	          rows ? 100.0 * cache->row_hits / rows : 0.0);
+}
+
+/**
+ * @brief Prints the hit rate of the entity delta cache for the current level.
+ */
+static void Sv_DeltaStats_f(void) {
+
+	if (!svs.initialized) {
+		Com_Print("No server running\n");
+		return;
+	}
+
+	sv_delta_cache_t *cache = &sv.delta_cache;
+
+	if (Cmd_Argc() > 1 && !g_strcmp0(Cmd_Argv(1), "clear")) {
+		SDL_AtomicSet(&cache->hits, 0);
+		SDL_AtomicSet(&cache->misses, 0);
+		return;
+	}
+
+	const int32_t hits = SDL_AtomicGet(&cache->hits);
+	const int32_t misses = SDL_AtomicGet(&cache->misses);
+
+	Com_Print("Entity deltas: %d hits, %d misses (%.1f%%)\n", hits, misses,
+	          hits + misses ? 100.0 * hits / (hits + misses) : 0.0);
+}
+
+/**
+ * @brief Prints the number of datagrams and system calls used to receive and
+ * send them. Useful for comparing batched (`net_batch`) and unbatched I/O.
+ */
+static void Sv_NetStats_f(void) {
+
+	net_udp_stats_t *stats = Net_DatagramStats(NS_UDP_SERVER);
+
+	if (Cmd_Argc() > 1 && !g_strcmp0(Cmd_Argv(1), "clear")) {
+		memset(stats, 0, sizeof(*stats));
+		return;
+	}
+
+	Com_Print("Received: %u datagrams in %u calls (%.1f per call)\n", stats->packets_received,
+	          stats->receive_calls, stats->packets_received / (double) MAX(stats->receive_calls, 1));
+	Com_Print("Sent: %u datagrams in %u calls (%.1f per call)\n", stats->packets_sent,
+	          stats->send_calls, stats->packets_sent / (double) MAX(stats->send_calls, 1));
+}
+
+/**
+ * @brief Prints the average cost of Sv_BoxEntities queries and Sv_Trace calls
+ * for the current level. Useful for comparing uniform and adaptive
+ * (`sv_adaptive_sectors`) sector trees, and for finding where the physics
+ * budget goes.
+ */
+static void Sv_WorldStats_f(void) {
+
+	if (!svs.initialized) {
+		Com_Print("No server running\n");
+		return;
+	}
+
+	sv_world_stats_t *stats = &sv.world_stats;
+	sv_trace_cache_stats_t *cache = &sv.trace_cache_stats;
+
+	if (Cmd_Argc() > 1 && !g_strcmp0(Cmd_Argv(1), "clear")) {
+		SDL_AtomicSet(&stats->queries, 0);
+		SDL_AtomicSet(&stats->sectors, 0);
+		SDL_AtomicSet(&stats->tests, 0);
+		SDL_AtomicSet(&stats->entities, 0);
+		SDL_AtomicSet(&stats->rebuilds, 0);
+		SDL_AtomicSet(&stats->frames, 0);
+		SDL_AtomicSet(&stats->traces, 0);
+		SDL_AtomicSet(&stats->candidates, 0);
+		SDL_AtomicSet(&stats->clips, 0);
+		SDL_AtomicSet(&cache->trace_hits, 0);
+		SDL_AtomicSet(&cache->trace_misses, 0);
+		SDL_AtomicSet(&cache->point_contents_hits, 0);
+		SDL_AtomicSet(&cache->point_contents_misses, 0);
+		return;
+	}
+
+	const uint32_t queries = SDL_AtomicGet(&stats->queries);
+	const uint32_t traces = SDL_AtomicGet(&stats->traces);
+	const uint32_t frames = SDL_AtomicGet(&stats->frames);
+
+	Com_Print("Queries: %u (sv_adaptive_sectors %d, %u rebuilds)\n", queries,
+	          sv_adaptive_sectors->integer, (uint32_t) SDL_AtomicGet(&stats->rebuilds));
+	Com_Print("Per query: %.1f sectors, %.1f entities tested, %.1f entities returned\n",
+	          (uint32_t) SDL_AtomicGet(&stats->sectors) / (double) MAX(queries, 1),
+	          (uint32_t) SDL_AtomicGet(&stats->tests) / (double) MAX(queries, 1),
+	          (uint32_t) SDL_AtomicGet(&stats->entities) / (double) MAX(queries, 1));
+
+	Com_Print("Traces: %u (%.1f per frame)\n", traces, traces / (double) MAX(frames, 1));
+	Com_Print("Per trace: %.1f candidates, %.1f clipped\n",
+	          (uint32_t) SDL_AtomicGet(&stats->candidates) / (double) MAX(traces, 1),
+	          (uint32_t) SDL_AtomicGet(&stats->clips) / (double) MAX(traces, 1));
+
+	const int32_t trace_hits = SDL_AtomicGet(&cache->trace_hits);
+	const int32_t trace_misses = SDL_AtomicGet(&cache->trace_misses);
+	const int32_t point_hits = SDL_AtomicGet(&cache->point_contents_hits);
+	const int32_t point_misses = SDL_AtomicGet(&cache->point_contents_misses);
+
+	Com_Print("Trace cache: %d hits, %d misses (%.1f%%, sv_trace_cache %d)\n", trace_hits, trace_misses,
+	          trace_hits + trace_misses ? 100.0 * trace_hits / (trace_hits + trace_misses) : 0.0,
+	          sv_trace_cache->integer);
+	Com_Print("Point contents cache: %d hits, %d misses (%.1f%%)\n", point_hits, point_misses,
+	          point_hits + point_misses ? 100.0 * point_hits / (point_hits + point_misses) : 0.0);
+}
+
 /**
  * @brief
  */
@@ -401,6 +565,11 @@ void Sv_InitAdmin(void) {
 	Cmd_Add("list_entities", Sv_ListEntities_f, CMD_SERVER, "List all entities in use");
 	Cmd_Add("server_info", Sv_ServerInfo_f, CMD_SERVER, "Print server info settings");
 	Cmd_Add("user_info", Sv_UserInfo_f, CMD_SERVER, "Print information for a given user");
+	Cmd_Add("send_stats", Sv_SendStats_f, CMD_SERVER, "Print per-tick client packet send cost by client count");
+	Cmd_Add("vis_stats", Sv_VisStats_f, CMD_SERVER, "Print client visibility cache hit rates");
+	Cmd_Add("delta_stats", Sv_DeltaStats_f, CMD_SERVER, "Print entity delta cache hit rates");
+	Cmd_Add("net_stats", Sv_NetStats_f, CMD_SERVER, "Print datagram system call counts");
+	Cmd_Add("world_stats", Sv_WorldStats_f, CMD_SERVER, "Print sector tree query and trace costs");
 
 	cmd_t *demo_cmd = Cmd_Add("demo", Sv_Demo_f, CMD_SERVER, "Start playback of the specified demo file");
 	Cmd_SetAutocomplete(demo_cmd, Sv_Demo_Autocomplete_f);
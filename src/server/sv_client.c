@@ -41,7 +41,7 @@ static void Sv_New_f(void) {
 
 	// send the server data
 	Net_WriteByte(&sv_client->net_chan.message, SV_CMD_SERVER_DATA);
-	Net_WriteShort(&sv_client->net_chan.message, PROTOCOL_MAJOR);
+	Net_WriteShort(&sv_client->net_chan.message, sv_client->protocol);
 	Net_WriteShort(&sv_client->net_chan.message, svs.game->protocol);
 	Net_WriteByte(&sv_client->net_chan.message, 0);
 	Net_WriteString(&sv_client->net_chan.message, Cvar_GetString("game"));
@@ -144,7 +144,7 @@ static void Sv_Baselines_f(void) {
 		base = &sv.baselines[start];
 		if (base->model1 || base->sound || base->effects) {
 			Net_WriteByte(&sv_client->net_chan.message, SV_CMD_BASELINE);
-			Net_WriteDeltaEntity(&sv_client->net_chan.message, &null_state, base, true);
+			Net_WriteDeltaEntity(&sv_client->net_chan.message, &null_state, base, true, sv_client->protocol);
 		}
 		start++;
 	}
@@ -21,11 +21,79 @@
 
 #include "sv_local.h"
 
+/**
+ * @brief Allocates the entity delta cache for the newly loaded level.
+ */
+void Sv_InitDeltaCache(void) {
+	sv_delta_cache_t *cache = &sv.delta_cache;
+
+	memset(cache, 0, sizeof(*cache));
+
+	cache->buckets = Mem_TagMalloc(MAX_ENTITIES * sizeof(sv_delta_cache_bucket_t), MEM_TAG_SERVER);
+}
+
+/**
+ * @brief Delta encodes the entity to the message, copying the encoding of any
+ * client that has already been sent the same delta.
+ *
+ * @return True if the delta was found in the cache, false otherwise.
+ */
+static _Bool Sv_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to,
+                                 _Bool force, const int32_t protocol) {
+
+	sv_delta_cache_bucket_t *bucket = &sv.delta_cache.buckets[to->number];
+
+	SDL_AtomicLock(&bucket->lock);
+
+	const sv_delta_cache_entry_t *entry = bucket->entries;
+	for (size_t i = 0; i < SV_DELTA_CACHE_WAYS; i++, entry++) {
+
+		if (entry->protocol != protocol || entry->force != force) {
+			continue;
+		}
+
+		if (memcmp(&entry->to, to, sizeof(*to)) || memcmp(&entry->from, from, sizeof(*from))) {
+			continue;
+		}
+
+		Net_WriteData(msg, entry->data, entry->size);
+
+		SDL_AtomicUnlock(&bucket->lock);
+		return true;
+	}
+
+	SDL_AtomicUnlock(&bucket->lock);
+
+	// encode it ourselves, outside of the lock
+	const size_t start = msg->size;
+
+	Net_WriteDeltaEntity(msg, from, to, force, protocol);
+
+	if (msg->overflowed || msg->size - start > SV_DELTA_CACHE_DATA) {
+		return false;
+	}
+
+	SDL_AtomicLock(&bucket->lock);
+
+	sv_delta_cache_entry_t *e = &bucket->entries[bucket->next++ % SV_DELTA_CACHE_WAYS];
+
+	e->from = *from;
+	e->to = *to;
+	e->protocol = protocol;
+	e->force = force;
+	e->size = (uint16_t) (msg->size - start);
+	memcpy(e->data, msg->data + start, e->size);
+
+	SDL_AtomicUnlock(&bucket->lock);
+	return false;
+}
+
 /**
  * @brief Writes a delta update of an entity_state_t list to the message.
  */
-static void Sv_WriteEntities(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
+static void Sv_WriteEntities(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg, const int32_t protocol) {
 	entity_state_t *old_state = NULL, *new_state = NULL;
+	int32_t hits = 0, misses = 0;
 	uint32_t old_index, new_index;
 	uint16_t old_num, new_num;
 	uint16_t from_num_entities;
@@ -55,23 +123,29 @@ static void Sv_WriteEntities(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
 		}
 
 		if (new_num == old_num) { // delta update from old position
-			Net_WriteDeltaEntity(msg, old_state, new_state, false);
+			if (Sv_WriteDeltaEntity(msg, old_state, new_state, false, protocol)) {
+				hits++;
+			} else {
+				misses++;
+			}
 			old_index++;
 			new_index++;
 			continue;
 		}
 
 		if (new_num < old_num) { // this is a new entity, send it from the baseline
-			Net_WriteDeltaEntity(msg, &sv.baselines[new_num], new_state, true);
+			if (Sv_WriteDeltaEntity(msg, &sv.baselines[new_num], new_state, true, protocol)) {
+				hits++;
+			} else {
+				misses++;
+			}
 			new_index++;
 			continue;
 		}
 
 		if (new_num > old_num) { // the old entity isn't present in the new message
-			const int16_t bits = U_REMOVE;
-
 			Net_WriteShort(msg, old_num);
-			Net_WriteShort(msg, bits);
+			Net_WriteDeltaEntityBits(msg, U_REMOVE, protocol);
 
 			old_index++;
 			continue;
@@ -79,18 +153,21 @@ static void Sv_WriteEntities(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
 	}
 
 	Net_WriteShort(msg, 0); // end of entities
+
+	SDL_AtomicAdd(&sv.delta_cache.hits, hits);
+	SDL_AtomicAdd(&sv.delta_cache.misses, misses);
 }
 
 /**
  * @brief
  */
-static void Sv_WritePlayerState(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
+static void Sv_WritePlayerState(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg, const int32_t protocol) {
 	static player_state_t null_state;
 
 	if (from) {
-		Net_WriteDeltaPlayerState(msg, &from->ps, &to->ps);
+		Net_WriteDeltaPlayerState(msg, &from->ps, &to->ps, protocol);
 	} else {
-		Net_WriteDeltaPlayerState(msg, &null_state, &to->ps);
+		Net_WriteDeltaPlayerState(msg, &null_state, &to->ps, protocol);
 	}
 }
 
@@ -129,21 +206,133 @@ void Sv_WriteClientFrame(sv_client_t *client, mem_buf_t *msg) {
 	Net_WriteData(msg, frame->area_bits, frame->area_bytes);
 
 	// delta encode the player state
-	Sv_WritePlayerState(delta_frame, frame, msg);
+	Sv_WritePlayerState(delta_frame, frame, msg, client->protocol);
 
 	// delta encode the entities
-	Sv_WriteEntities(delta_frame, frame, msg);
+	Sv_WriteEntities(delta_frame, frame, msg, client->protocol);
+}
+
+/**
+ * @brief Allocates the visibility cache for the newly loaded level.
+ */
+void Sv_InitVisibility(void) {
+	sv_vis_cache_t *cache = &sv.vis_cache;
+
+	memset(cache, 0, sizeof(*cache));
+
+	cache->vis_len = (Cm_NumClusters() + 7) >> 3;
+	cache->data = Mem_TagMalloc(SV_VIS_CACHE_SIZE * cache->vis_len * 2, MEM_TAG_SERVER);
+
+	byte *data = cache->data;
+	for (size_t i = 0; i < SV_VIS_CACHE_SIZE; i++) {
+		cache->entries[i].pvs = data;
+		data += cache->vis_len;
+		cache->entries[i].phs = data;
+		data += cache->vis_len;
+	}
+}
+
+/**
+ * @return The cache entry for the specified sorted cluster set, or NULL.
+ */
+static sv_vis_cache_entry_t *Sv_FindVisibility(const int32_t *clusters, const int32_t num_clusters,
+                                                const uint32_t hash) {
+
+	sv_vis_cache_entry_t *entry = sv.vis_cache.entries;
+	for (size_t i = 0; i < SV_VIS_CACHE_SIZE; i++, entry++) {
+
+		if (entry->num_clusters != num_clusters || entry->hash != hash) {
+			continue;
+		}
+
+		if (memcmp(entry->clusters, clusters, num_clusters * sizeof(int32_t))) {
+			continue;
+		}
+
+		entry->last_used = ++sv.vis_cache.time;
+		return entry;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Evicts the least recently used cache entry and assigns it to the
+ * specified cluster set. The caller is responsible for populating its rows.
+ */
+static sv_vis_cache_entry_t *Sv_AllocVisibility(const int32_t *clusters, const int32_t num_clusters,
+                                                 const uint32_t hash) {
+
+	sv_vis_cache_entry_t *entry = sv.vis_cache.entries;
+	sv_vis_cache_entry_t *e = entry;
+
+	for (size_t i = 0; i < SV_VIS_CACHE_SIZE; i++, e++) {
+		if (e->num_clusters == 0) {
+			entry = e;
+			break;
+		}
+		if (e->last_used < entry->last_used) {
+			entry = e;
+		}
+	}
+
+	memcpy(entry->clusters, clusters, num_clusters * sizeof(int32_t));
+	entry->num_clusters = num_clusters;
+	entry->hash = hash;
+	entry->last_used = ++sv.vis_cache.time;
+
+	return entry;
+}
+
+/**
+ * @return A hash code for the specified sorted cluster set.
+ */
+static uint32_t Sv_HashVisibility(const int32_t *clusters, const int32_t num_clusters) {
+
+	uint32_t hash = 5381;
+	for (int32_t i = 0; i < num_clusters; i++) {
+		hash = hash * 33 + (uint32_t) clusters[i];
+	}
+
+	return hash;
+}
+
+/**
+ * @brief Resolves the cached, decompressed visibility for a single cluster.
+ *
+ * @remarks The visibility cache must be locked.
+ */
+static const sv_vis_cache_entry_t *Sv_ClusterVisibility(const int32_t cluster) {
+
+	const uint32_t hash = Sv_HashVisibility(&cluster, 1);
+
+	sv_vis_cache_entry_t *entry = Sv_FindVisibility(&cluster, 1, hash);
+	if (entry) {
+		sv.vis_cache.row_hits++;
+	} else {
+		sv.vis_cache.row_misses++;
+
+		entry = Sv_AllocVisibility(&cluster, 1, hash);
+
+		Cm_ClusterPVS(cluster, entry->pvs);
+		Cm_ClusterPHS(cluster, entry->phs);
+	}
+
+	return entry;
 }
 
 /**
  * @brief Resolve the visibility data for the bounding box around the client. The
  * bounding box provides some leniency because the client's actual view origin
  * is likely slightly different than what we think it is.
+ *
+ * @remarks Only the first `sv.vis_cache.vis_len` bytes of `pvs` and `phs` are
+ * written, which covers every cluster in the level.
  */
 static void Sv_ClientVisibility(const vec3_t org, byte *pvs, byte *phs) {
 	int32_t leafs[MAX_ENT_LEAFS];
 	int32_t clusters[MAX_ENT_CLUSTERS];
-	size_t num_clusters = 0;
+	int32_t num_clusters = 0;
 	vec3_t mins, maxs;
 
 	// spread the bounds to account for view offset
@@ -159,48 +348,77 @@ static void Sv_ClientVisibility(const vec3_t org, byte *pvs, byte *phs) {
 		Com_Warn("MAX_ENT_LEAFS for client @ %s\n", vtos(org));
 	}
 
-	memset(pvs, 0, MAX_BSP_LEAFS >> 3);
-	memset(phs, 0, MAX_BSP_LEAFS >> 3);
-
-	// convert leafs to clusters and combine their visibility data
+	// convert leafs to a sorted set of unique clusters
 	for (size_t i = 0; i < len; i++) {
 
 		const int32_t cluster = Cm_LeafCluster(leafs[i]);
 
-		size_t j;
+		int32_t j;
 		for (j = 0; j < num_clusters; j++) {
-			if (clusters[j] == cluster) {
+			if (clusters[j] >= cluster) {
 				break;
 			}
 		}
 
-		if (j < num_clusters) { // already got it
+		if (j < num_clusters && clusters[j] == cluster) { // already got it
 			continue;
 		}
 
-		clusters[num_clusters++] = cluster;
+		if (num_clusters == lengthof(clusters)) {
+			Com_Warn("MAX_ENT_CLUSTERS for client @ %s\n", vtos(org));
+			break;
+		}
+
+		memmove(clusters + j + 1, clusters + j, (num_clusters - j) * sizeof(int32_t));
+		clusters[j] = cluster;
+		num_clusters++;
+	}
+
+	sv_vis_cache_t *cache = &sv.vis_cache;
+	const uint32_t hash = Sv_HashVisibility(clusters, num_clusters);
+
+	SDL_AtomicLock(&cache->lock);
+
+	const sv_vis_cache_entry_t *entry = Sv_FindVisibility(clusters, num_clusters, hash);
+	if (entry) {
+		cache->set_hits++;
+
+		memcpy(pvs, entry->pvs, cache->vis_len);
+		memcpy(phs, entry->phs, cache->vis_len);
+	} else {
+		cache->set_misses++;
 
-		byte cluster_pvs[MAX_BSP_LEAFS >> 3];
-		byte cluster_phs[MAX_BSP_LEAFS >> 3];
+		memset(pvs, 0, cache->vis_len);
+		memset(phs, 0, cache->vis_len);
 
-		Cm_ClusterPVS(cluster, cluster_pvs);
-		Cm_ClusterPHS(cluster, cluster_phs);
+		// combine the visibility data of each cluster
+		for (int32_t i = 0; i < num_clusters; i++) {
+			const sv_vis_cache_entry_t *row = Sv_ClusterVisibility(clusters[i]);
 
-		for (size_t n = 0; n < sizeof(cluster_pvs); n++) {
-			pvs[n] |= cluster_pvs[n];
-			phs[n] |= cluster_phs[n];
+			for (size_t n = 0; n < cache->vis_len; n++) {
+				pvs[n] |= row->pvs[n];
+				phs[n] |= row->phs[n];
+			}
 		}
 
-		if (num_clusters == lengthof(clusters)) {
-			Com_Warn("MAX_ENT_CLUSTERS for client @ %s\n", vtos(org));
-			break;
+		// and remember the merged result for other clients in the same clusters
+		if (num_clusters > 1) {
+			sv_vis_cache_entry_t *e = Sv_AllocVisibility(clusters, num_clusters, hash);
+
+			memcpy(e->pvs, pvs, cache->vis_len);
+			memcpy(e->phs, phs, cache->vis_len);
 		}
 	}
+
+	SDL_AtomicUnlock(&cache->lock);
 }
 
 /**
  * @brief Decides which entities are going to be visible to the client, and
  * copies off the player state and area_bits.
+ *
+ * @remarks This is called from worker threads when `sv_threads` is set, so
+ * it must only write to the client's own frame and reserved entity states.
  */
 void Sv_BuildClientFrame(sv_client_t *client) {
 	vec3_t org, off;
@@ -232,11 +450,28 @@ void Sv_BuildClientFrame(sv_client_t *client) {
 	byte pvs[MAX_BSP_LEAFS >> 3], phs[MAX_BSP_LEAFS >> 3];
 	Sv_ClientVisibility(org, pvs, phs);
 
+	// resolve the candidate entities in the PHS, which is a superset of the PVS
+	byte candidates[MAX_ENTITIES >> 3];
+	Sv_ClusterEntities(phs, candidates);
+
+	const uint16_t client_num = NUM_FOR_ENTITY(cent);
+	candidates[client_num >> 3] |= 1 << (client_num & 7);
+
 	// build up the list of relevant entities
-	frame->num_entities = 0;
-	frame->entity_state = svs.next_entity_state;
+	uint16_t entities[MAX_ENTITIES];
+	uint16_t num_entities = 0;
 
 	for (uint16_t e = 1; e < svs.game->num_entities; e++) {
+
+		if (candidates[e >> 3] == 0) { // skip 8 entities at a time
+			e |= 7;
+			continue;
+		}
+
+		if (!(candidates[e >> 3] & (1 << (e & 7)))) {
+			continue;
+		}
+
 		g_entity_t *ent = ENTITY_FOR_NUM(e);
 
 		// ignore entities that are local to the server
@@ -280,8 +515,20 @@ void Sv_BuildClientFrame(sv_client_t *client) {
 			}
 		}
 
+		entities[num_entities++] = e;
+	}
+
+	// reserve space in the circular entity_state_t array, which may be shared
+	// with other threads building frames for other clients
+	frame->num_entities = num_entities;
+	frame->entity_state = (uint32_t) SDL_AtomicAdd(&svs.next_entity_state, num_entities);
+
+	for (uint16_t i = 0; i < num_entities; i++) {
+		const uint16_t e = entities[i];
+		g_entity_t *ent = ENTITY_FOR_NUM(e);
+
 		// copy it to the circular entity_state_t array
-		entity_state_t *s = &svs.entity_states[svs.next_entity_state % svs.num_entity_states];
+		entity_state_t *s = &svs.entity_states[(frame->entity_state + i) % svs.num_entity_states];
 		if (ent->s.number != e) {
 			Com_Warn("Fixing entity number: %d -> %d\n", ent->s.number, e);
 			ent->s.number = e;
@@ -292,8 +539,5 @@ void Sv_BuildClientFrame(sv_client_t *client) {
 		if (ent->owner == client->entity) {
 			s->solid = SOLID_NOT;
 		}
-
-		svs.next_entity_state++;
-		frame->num_entities++;
 	}
 }
@@ -26,4 +26,6 @@
 #ifdef __SV_LOCAL_H__
 void Sv_WriteClientFrame(sv_client_t *client, mem_buf_t *msg);
 void Sv_BuildClientFrame(sv_client_t *client);
+void Sv_InitVisibility(void);
+void Sv_InitDeltaCache(void);
 #endif /* __SV_LOCAL_H__ */
@@ -338,6 +338,10 @@ void Sv_InitGame(void) {
 	import.Free = Mem_Free;
 	import.FreeTag = Mem_FreeTag;
 
+	import.Submit = Thread_Submit;
+	import.ParallelFor = Thread_ParallelFor;
+	import.WaitCounter = Thread_WaitCounter;
+
 	import.LoadFile = Fs_Load;
 	import.FreeFile = Fs_Free;
 	import.Mkdir = Fs_Mkdir;
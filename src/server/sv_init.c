@@ -143,6 +143,14 @@ static void Sv_ClearState() {
 		}
 	}
 
+	if (sv.vis_cache.data) {
+		Mem_Free(sv.vis_cache.data);
+	}
+
+	if (sv.delta_cache.buckets) {
+		Mem_Free(sv.delta_cache.buckets);
+	}
+
 	memset(&sv, 0, sizeof(sv));
 	Com_QuitSubsystem(QUETOO_SERVER);
 
@@ -177,11 +185,16 @@ static void Sv_ShutdownClients(void) {
 		if (cl->download.buffer) {
 			Fs_Free(cl->download.buffer);
 		}
+
+		Mem_DestroyArena(cl->datagram.arena);
 	}
 
 	Mem_Free(svs.clients);
 	svs.clients = NULL;
 
+	g_hash_table_destroy(svs.client_addresses);
+	svs.client_addresses = NULL;
+
 	Mem_Free(svs.entity_states);
 	svs.entity_states = NULL;
 }
@@ -204,6 +217,11 @@ static void Sv_InitEntities(sv_state_t state) {
 		// initialize the clients array
 		svs.clients = Mem_TagMalloc(sizeof(sv_client_t) * sv_max_clients->integer, MEM_TAG_SERVER);
 
+		for (int32_t i = 0; i < sv_max_clients->integer; i++) {
+			svs.clients[i].datagram.arena = Mem_CreateArena(SV_CLIENT_ARENA_SIZE, MEM_TAG_SERVER);
+		}
+		svs.client_addresses = g_hash_table_new(g_int64_hash, g_int64_equal);
+
 		// and the entity states array
 		svs.num_entity_states = sv_max_clients->integer * PACKET_BACKUP * MAX_PACKET_ENTITIES;
 		svs.entity_states = Mem_TagMalloc(sizeof(entity_state_t) * svs.num_entity_states, MEM_TAG_SERVER);
@@ -284,6 +302,10 @@ static void Sv_LoadMedia(const char *server, sv_state_t state) {
 
 		Sv_InitWorld();
 
+		Sv_InitVisibility();
+
+		Sv_InitDeltaCache();
+
 		svs.game->SpawnEntities(sv.name, Cm_EntityString());
 
 		/*
@@ -29,6 +29,7 @@ sv_server_t sv; // per-level server info
 
 sv_client_t *sv_client; // current client
 
+cvar_t *sv_adaptive_sectors;
 cvar_t *sv_demo_list;
 cvar_t *sv_download_url;
 cvar_t *sv_enforce_time;
@@ -37,23 +38,71 @@ cvar_t *sv_max_clients;
 cvar_t *sv_no_areas;
 cvar_t *sv_public;
 cvar_t *sv_rcon_password; // password for remote server commands
+cvar_t *sv_threads;
 cvar_t *sv_timeout;
+cvar_t *sv_trace_cache;
 cvar_t *sv_udp_download;
 
+/**
+ * @return The svs.client_addresses key for the given address and qport. The
+ * port is excluded, as address translating routers may change it.
+ */
+static gint64 Sv_ClientAddressKey(const net_addr_t *addr, const uint8_t qport) {
+	return ((gint64) addr->type << 40) | ((gint64) addr->addr << 8) | qport;
+}
+
+/**
+ * @brief Adds the client to the address table, by its net channel's address
+ * and qport. Should several clients share a key, the lowest slot wins, as it
+ * would with a linear search.
+ */
+void Sv_LinkClientAddress(sv_client_t *cl) {
+
+	cl->address_key = Sv_ClientAddressKey(&cl->net_chan.remote_address, cl->net_chan.qport);
+
+	const sv_client_t *other = g_hash_table_lookup(svs.client_addresses, &cl->address_key);
+	if (other == NULL || other > cl) {
+		// replace the key, too, as the table must never reference another client's key
+		g_hash_table_replace(svs.client_addresses, &cl->address_key, cl);
+	}
+}
+
+/**
+ * @brief Removes the client from the address table, promoting any other client
+ * sharing its key.
+ */
+void Sv_UnlinkClientAddress(sv_client_t *cl) {
+
+	if (g_hash_table_lookup(svs.client_addresses, &cl->address_key) != cl) {
+		return;
+	}
+
+	g_hash_table_remove(svs.client_addresses, &cl->address_key);
+
+	sv_client_t *other = svs.clients;
+	for (int32_t i = 0; i < sv_max_clients->integer; i++, other++) {
+
+		if (other == cl || other->state == SV_CLIENT_FREE) {
+			continue;
+		}
+
+		if (other->address_key == cl->address_key) {
+			g_hash_table_replace(svs.client_addresses, &other->address_key, other);
+			break;
+		}
+	}
+}
+
 /**
  * @brief Called when the player is totally leaving the server, either willingly
  * or unwillingly. This is NOT called if the entire server is quitting
  * or crashing.
  */
 void Sv_DropClient(sv_client_t *cl) {
-	g_entity_t *ent;
 
 	Mem_ClearBuffer(&cl->net_chan.message);
-	Mem_ClearBuffer(&cl->datagram.buffer);
 
-	if (cl->datagram.messages) {
-		g_list_free_full(cl->datagram.messages, Mem_Free);
-	}
+	Sv_ClearClientDatagram(cl);
 
 	if (cl->state > SV_CLIENT_FREE) { // send the disconnect
 
@@ -69,11 +118,15 @@ void Sv_DropClient(sv_client_t *cl) {
 		Fs_Free(cl->download.buffer);
 	}
 
-	ent = cl->entity;
+	Sv_UnlinkClientAddress(cl);
+
+	g_entity_t *ent = cl->entity;
+	mem_arena_t *arena = cl->datagram.arena;
 
 	memset(cl, 0, sizeof(*cl));
 
 	cl->entity = ent;
+	cl->datagram.arena = arena;
 	cl->last_frame = -1;
 }
 
@@ -136,7 +189,7 @@ static void Sv_Info_f(void) {
 	}
 
 	const int32_t p = atoi(Cmd_Argv(1));
-	if (p != PROTOCOL_MAJOR) {
+	if (p != PROTOCOL_MAJOR && p != PROTOCOL_MAJOR_LEGACY) {
 		g_snprintf(string, sizeof(string), "%s: Wrong protocol: %d != %d", sv_hostname->string, p,
 		           PROTOCOL_MAJOR);
 	} else {
@@ -215,7 +268,7 @@ static void Sv_Connect_f(void) {
 	const int32_t version = (int32_t) strtol(Cmd_Argv(1), NULL, 0);
 
 	// resolve protocol
-	if (version != PROTOCOL_MAJOR) {
+	if (version != PROTOCOL_MAJOR && version != PROTOCOL_MAJOR_LEGACY) {
 		Netchan_OutOfBandPrint(NS_UDP_SERVER, addr, "print\nServer is version %d.\n",
 		                       PROTOCOL_MAJOR);
 		return;
@@ -342,8 +395,14 @@ static void Sv_Connect_f(void) {
 	// send the connect packet to the client
 	Netchan_OutOfBandPrint(NS_UDP_SERVER, addr, "client_connect %s", sv_download_url->string);
 
+	Sv_UnlinkClientAddress(client);
+
 	Netchan_Setup(NS_UDP_SERVER, &client->net_chan, addr, qport);
 
+	Sv_LinkClientAddress(client);
+
+	client->protocol = version;
+
 	Mem_InitBuffer(&client->datagram.buffer, client->datagram.data, sizeof(client->datagram.data));
 	client->datagram.buffer.allow_overflow = true;
 
@@ -561,34 +620,22 @@ static void Sv_ReadPackets(void) {
 		const byte qport = Net_ReadByte(&net_message) & 0xff;
 
 		// check for packets from connected clients
-		sv_client_t *cl = svs.clients;
-		for (int32_t i = 0; i < sv_max_clients->integer; i++, cl++) {
-
-			if (cl->state == SV_CLIENT_FREE) {
-				continue;
-			}
-
-			if (!Net_CompareClientNetaddr(&net_from, &cl->net_chan.remote_address)) {
-				continue;
-			}
+		const gint64 key = Sv_ClientAddressKey(&net_from, qport);
 
-			if (cl->net_chan.qport != qport) {
-				continue;
-			}
-
-			if (cl->net_chan.remote_address.port != net_from.port) {
-				cl->net_chan.remote_address.port = net_from.port;
-				Com_Warn("Fixed translated port for %s\n", Net_NetaddrToString(&net_from));
-			}
+		sv_client_t *cl = g_hash_table_lookup(svs.client_addresses, &key);
+		if (cl == NULL) {
+			continue;
+		}
 
-			// this is a valid, sequenced packet, so process it
-			if (Netchan_Process(&cl->net_chan, &net_message)) {
-				cl->last_message = quetoo.ticks; // nudge timeout
-				Sv_ParseClientMessage(cl);
-			}
+		if (cl->net_chan.remote_address.port != net_from.port) {
+			cl->net_chan.remote_address.port = net_from.port;
+			Com_Warn("Fixed translated port for %s\n", Net_NetaddrToString(&net_from));
+		}
 
-			// we've processed the packet for the correct client, so break
-			break;
+		// this is a valid, sequenced packet, so process it
+		if (Netchan_Process(&cl->net_chan, &net_message)) {
+			cl->last_message = quetoo.ticks; // nudge timeout
+			Sv_ParseClientMessage(cl);
 		}
 	}
 }
@@ -646,6 +693,8 @@ static void Sv_RunGameFrame(void) {
 	sv.time = sv.frame_num * QUETOO_TICK_MILLIS;
 
 	if (sv.state == SV_ACTIVE_GAME) {
+		Sv_UpdateWorld();
+
 		svs.game->Frame();
 	}
 }
@@ -770,6 +819,9 @@ void Sv_Frame(const uint32_t msec) {
 	// clamp the frame interval to 1 second of simulation
 	frame_delta = Min(frame_delta, (uint32_t) (QUETOO_TICK_MILLIS * QUETOO_TICK_RATE));
 
+	// queue outgoing datagrams so that they are sent in as few system calls as possible
+	Net_BeginDatagrams(NS_UDP_SERVER);
+
 	// read any pending packets from clients
 	Sv_ReadPackets();
 
@@ -798,6 +850,9 @@ void Sv_Frame(const uint32_t msec) {
 		frame_delta -= QUETOO_TICK_MILLIS;
 	}
 
+	// and send them
+	Net_FlushDatagrams(NS_UDP_SERVER);
+
 	// clear entity flags, etc for next frame
 	Sv_ResetEntities();
 
@@ -810,6 +865,8 @@ void Sv_Frame(const uint32_t msec) {
  */
 static void Sv_InitLocal(void) {
 
+	sv_adaptive_sectors = Cvar_Add("sv_adaptive_sectors", "0", CVAR_ARCHIVE,
+	                               "If set, the world sector tree is periodically rebuilt around the entities it contains");
 	sv_demo_list = Cvar_Add("sv_demo_list", "", CVAR_SERVER_INFO,
 	                        "A list of demo names to cycle through");
 	sv_download_url = Cvar_Add("sv_download_url", "", CVAR_SERVER_INFO,
@@ -826,7 +883,11 @@ static void Sv_InitLocal(void) {
 	                     "Set to 1 to to advertise this server via the master server");
 	sv_rcon_password = Cvar_Add("rcon_password", "", 0,
 	                            "The remote console password. If set, only give this to trusted clients");
+	sv_threads = Cvar_Add("sv_threads", "0", CVAR_ARCHIVE,
+	                      "If set, client frames are built and encoded in parallel using the thread pool");
 	sv_timeout = Cvar_Add("sv_timeout", va("%d", SV_TIMEOUT), 0, NULL);
+	sv_trace_cache = Cvar_Add("sv_trace_cache", "0", CVAR_ARCHIVE,
+	                          "If set, identical traces and point contents queries within a tick are memoized");
 	sv_udp_download = Cvar_Add("sv_udp_download", "1", CVAR_ARCHIVE,
 	                           "If set, in-game UDP downloads will be allowed when HTTP downloads fail");
 
@@ -29,6 +29,7 @@ void Sv_Frame(const uint32_t msec);
 
 #ifdef __SV_LOCAL_H__
 // cvars
+extern cvar_t *sv_adaptive_sectors;
 extern cvar_t *sv_demo_list;
 extern cvar_t *sv_download_url;
 extern cvar_t *sv_enforce_time;
@@ -37,7 +38,9 @@ extern cvar_t *sv_max_clients;
 extern cvar_t *sv_no_areas;
 extern cvar_t *sv_public;
 extern cvar_t *sv_rcon_password;
+extern cvar_t *sv_threads;
 extern cvar_t *sv_timeout;
+extern cvar_t *sv_trace_cache;
 extern cvar_t *sv_udp_download;
 
 // per-level and static server structures
@@ -50,6 +53,8 @@ extern g_entity_t *sv_player;
 
 const char *Sv_StatusString(void);
 const char *Sv_NetaddrToString(const sv_client_t *cl);
+void Sv_LinkClientAddress(sv_client_t *cl);
+void Sv_UnlinkClientAddress(sv_client_t *cl);
 void Sv_KickClient(sv_client_t *cl, const char *msg);
 void Sv_DropClient(sv_client_t *cl);
 void Sv_UserInfoChanged(sv_client_t *cl);
@@ -19,6 +19,8 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <SDL_timer.h>
+
 #include "sv_local.h"
 
 /**
@@ -119,6 +121,20 @@ void Sv_BroadcastCommand(const char *fmt, ...) {
 	Sv_Multicast(NULL, MULTICAST_ALL_R, NULL);
 }
 
+/**
+ * @brief Clears the client's datagram buffer and releases its messages.
+ */
+void Sv_ClearClientDatagram(sv_client_t *cl) {
+
+	Mem_ClearBuffer(&cl->datagram.buffer);
+
+	cl->datagram.messages = cl->datagram.last_message = NULL;
+
+	if (cl->datagram.arena) {
+		Mem_ResetArena(cl->datagram.arena);
+	}
+}
+
 /**
  * @brief Writes to the specified datagram, noting the offset of the message.
  */
@@ -128,23 +144,27 @@ static void Sv_ClientDatagramMessage(sv_client_t *cl, byte *data, size_t len) {
 		Com_Error(ERROR_DROP, "Single datagram message exceeded MAX_MSG_LEN\n");
 	}
 
-	sv_client_message_t *msg = g_malloc0(sizeof(*msg));
+	sv_client_message_t *msg = Mem_ArenaMalloc(cl->datagram.arena, sizeof(*msg));
 
 	msg->offset = cl->datagram.buffer.size;
 	msg->len = len;
 
-	cl->datagram.messages = g_list_append(cl->datagram.messages, msg);
+	if (cl->datagram.last_message) {
+		cl->datagram.last_message->next = msg;
+	} else {
+		cl->datagram.messages = msg;
+	}
+
+	cl->datagram.last_message = msg;
 
 	Mem_WriteBuffer(&cl->datagram.buffer, data, len);
 
 	if (cl->datagram.buffer.overflowed) {
 		Com_Warn("Client datagram overflow for %s\n", cl->name);
 
-		msg->offset = 0;
 		cl->datagram.buffer.overflowed = false;
 
-		g_list_free_full(cl->datagram.messages, g_free);
-		cl->datagram.messages = NULL;
+		Sv_ClearClientDatagram(cl);
 	}
 }
 
@@ -350,51 +370,101 @@ void Sv_PositionedSound(const vec3_t origin, const g_entity_t *ent, const uint16
 }
 
 /**
- * @brief
+ * @brief Builds and delta-encodes the frame for the specified client into its
+ * frame message buffer.
  */
-static void Sv_SendClientDatagram(sv_client_t *cl) {
-	byte buffer[MAX_MSG_SIZE];
-	mem_buf_t buf;
+static void Sv_WriteClientFrameMessage(sv_client_t *cl) {
 
 	Sv_BuildClientFrame(cl);
 
-	Mem_InitBuffer(&buf, buffer, sizeof(buffer));
-	buf.allow_overflow = true;
+	Mem_InitBuffer(&cl->frame_message, cl->frame_message_data, sizeof(cl->frame_message_data));
+	cl->frame_message.allow_overflow = true;
+
+	// send over all the relevant entity_state_t and the player_state_t
+	Sv_WriteClientFrame(cl, &cl->frame_message);
+}
+
+/**
+ * @brief ThreadRangeFunc for Sv_WriteClientFrameMessages.
+ */
+static void Sv_WriteClientFrameMessages_Range(size_t start, size_t end, void *data) {
+
+	sv_client_t **clients = (sv_client_t **) data;
+
+	for (size_t i = start; i < end; i++) {
+		Sv_WriteClientFrameMessage(clients[i]);
+	}
+}
+
+/**
+ * @brief Builds and encodes frames for the specified clients. If `sv_threads`
+ * is set, each client is a job, so that idle workers may steal from busy ones.
+ */
+static void Sv_WriteClientFrameMessages(sv_client_t **clients, const size_t num_clients) {
+
+	if (sv_threads->integer) {
+		Thread_ParallelFor(num_clients, 1, Sv_WriteClientFrameMessages_Range, clients);
+	} else {
+		Sv_WriteClientFrameMessages_Range(0, num_clients, clients);
+	}
+}
+
+/**
+ * @brief Packetizes and transmits the client's frame message and any pending
+ * datagram messages. Packets are gathered from the frame message and datagram
+ * buffers in place, rather than copied together.
+ */
+static void Sv_SendClientDatagram(sv_client_t *cl) {
+	net_iovec_t segments[NETCHAN_MAX_SEGMENTS];
+
+	const mem_buf_t *buf = &cl->frame_message;
 
 	// accumulate the total size for rate throttling
 	size_t frame_size = 0;
 
-	// send over all the relevant entity_state_t and the player_state_t
-	Sv_WriteClientFrame(cl, &buf);
-
 	// the frame itself (player state and delta entities) must fit into a single message,
 	// since it is parsed as a single command by the client
-	if (buf.overflowed || buf.size > MAX_MSG_SIZE - 16) {
-		Com_Error(ERROR_DROP, "Frame exceeds MAX_MSG_SIZE (%u)\n", (uint32_t) buf.size);
+	if (buf->overflowed || buf->size > MAX_MSG_SIZE - 16) {
+		Com_Error(ERROR_DROP, "Frame exceeds MAX_MSG_SIZE (%u)\n", (uint32_t) buf->size);
 	}
 
+	segments[0] = (net_iovec_t) { .data = buf->data, .len = buf->size };
+
+	size_t num_segments = 1, size = buf->size;
+
 	// but we can packetize the remaining datagram messages, which are parsed individually
-	const GList *e = cl->datagram.messages;
-	while (e) {
-		const sv_client_message_t *msg = (sv_client_message_t *) e->data;
+	const sv_client_message_t *msg = cl->datagram.messages;
+	while (msg) {
+		const byte *data = cl->datagram.buffer.data + msg->offset;
+
+		// messages are written sequentially, so they usually extend the last segment
+		net_iovec_t *last = num_segments ? &segments[num_segments - 1] : NULL;
+		_Bool contiguous = last && (const byte *) last->data + last->len == data;
 
 		// if we would overflow the packet, flush it first
-		if (buf.size + msg->len > (MAX_MSG_SIZE - 16)) {
-			Com_Debug(DEBUG_SERVER, "Fragmenting datagram @ %u bytes\n", (uint32_t) buf.size);
+		if (size + msg->len > (MAX_MSG_SIZE - 16) || (!contiguous && num_segments == lengthof(segments))) {
+			Com_Debug(DEBUG_SERVER, "Fragmenting datagram @ %u bytes\n", (uint32_t) size);
+
+			Netchan_Transmitv(&cl->net_chan, segments, num_segments);
+			frame_size += size;
 
-			Netchan_Transmit(&cl->net_chan, buf.data, buf.size);
-			frame_size += buf.size;
+			num_segments = size = 0;
+			contiguous = false;
+		}
 
-			Mem_ClearBuffer(&buf);
+		if (contiguous) {
+			last->len += msg->len;
+		} else {
+			segments[num_segments++] = (net_iovec_t) { .data = data, .len = msg->len };
 		}
 
-		Mem_WriteBuffer(&buf, cl->datagram.buffer.data + msg->offset, msg->len);
-		e = e->next;
+		size += msg->len;
+		msg = msg->next;
 	}
 
 	// send the pending packet, which may include reliable messages
-	Netchan_Transmit(&cl->net_chan, buf.data, buf.size);
-	frame_size += buf.size;
+	Netchan_Transmitv(&cl->net_chan, segments, num_segments);
+	frame_size += size;
 
 	// record the total size for rate estimation
 	cl->frame_size[sv.frame_num % QUETOO_TICK_RATE] = frame_size;
@@ -518,8 +588,12 @@ static size_t Sv_GetDemoMessage(byte *buffer) {
 
 /**
  * @brief Send the frame and all pending datagram messages since the last frame.
+ * Frames are built and encoded first, possibly in parallel, and then all
+ * packets are transmitted from the main thread in client order.
  */
 void Sv_SendClientPackets(void) {
+	sv_client_t *clients[MAX_CLIENTS];
+	size_t num_clients = 0;
 	sv_client_t *cl;
 	int32_t i;
 
@@ -527,7 +601,9 @@ void Sv_SendClientPackets(void) {
 		return;
 	}
 
-	// send a message to each connected client
+	const uint64_t start = SDL_GetPerformanceCounter();
+
+	// drop overflowed clients, and resolve which clients will receive a frame
 	for (i = 0, cl = svs.clients; i < sv_max_clients->integer; i++, cl++) {
 
 		if (cl->state == SV_CLIENT_FREE) { // don't bother
@@ -541,6 +617,27 @@ void Sv_SendClientPackets(void) {
 			continue;
 		}
 
+		if (sv.state != SV_ACTIVE_DEMO && cl->state == SV_CLIENT_ACTIVE) {
+
+			if (Sv_RateDrop(cl)) { // enforce rate throttle
+				cl->frame_size[sv.frame_num % lengthof(cl->frame_size)] = 0;
+			} else {
+				clients[num_clients++] = cl;
+			}
+		}
+	}
+
+	// build and encode the frames
+	Sv_WriteClientFrameMessages(clients, num_clients);
+
+	// send a message to each connected client
+	size_t c = 0;
+	for (i = 0, cl = svs.clients; i < sv_max_clients->integer; i++, cl++) {
+
+		if (cl->state == SV_CLIENT_FREE) { // don't bother
+			continue;
+		}
+
 		if (sv.state == SV_ACTIVE_DEMO) { // send the demo packet
 			byte buffer[MAX_MSG_SIZE];
 			size_t size;
@@ -552,20 +649,13 @@ void Sv_SendClientPackets(void) {
 			}
 		} else if (cl->state == SV_CLIENT_ACTIVE) { // send the game packet
 
-			if (Sv_RateDrop(cl)) { // enforce rate throttle
-				cl->frame_size[sv.frame_num % lengthof(cl->frame_size)] = 0;
-			} else {
+			if (c < num_clients && clients[c] == cl) {
 				Sv_SendClientDatagram(cl);
+				c++;
 			}
 
 			// clean up for the next frame
-			Mem_ClearBuffer(&cl->datagram.buffer);
-
-			if (cl->datagram.messages) {
-				g_list_free_full(cl->datagram.messages, g_free);
-			}
-
-			cl->datagram.messages = NULL;
+			Sv_ClearClientDatagram(cl);
 
 		} else if (cl->net_chan.message.size) { // update reliable
 			Netchan_Transmit(&cl->net_chan, NULL, 0);
@@ -573,4 +663,9 @@ void Sv_SendClientPackets(void) {
 			Netchan_Transmit(&cl->net_chan, NULL, 0);
 		}
 	}
+
+	sv_send_stats_t *stats = &svs.send_stats[num_clients];
+
+	stats->ticks++;
+	stats->time += SDL_GetPerformanceCounter() - start;
 }
@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include <SDL_atomic.h>
+
 #include "game/game.h"
 #include "ai/ai.h"
 #include "matrix.h"
@@ -51,14 +53,150 @@ typedef struct {
 
 	int32_t clusters[MAX_ENT_CLUSTERS];
 	int32_t num_clusters; // if -1, use top_node
+	_Bool clustered; // true if linked into the cluster entity index
 
 	int32_t areas[2];
+
 	struct sv_sector_s *sector;
+	uint16_t sector_prev, sector_next; // sector membership, by entity number
 
 	matrix4x4_t matrix;
 	matrix4x4_t inverse_matrix;
 } sv_entity_t;
 
+/**
+ * @brief The number of cluster sets for which decompressed visibility is cached.
+ */
+#define SV_VIS_CACHE_SIZE 128
+
+/**
+ * @brief Merged PVS and PHS for a sorted set of clusters. Single-cluster
+ * entries double as the cache of decompressed cluster rows.
+ */
+typedef struct {
+	int32_t clusters[MAX_ENT_CLUSTERS];
+	int32_t num_clusters; // 0 if unused
+	uint32_t hash;
+	uint32_t last_used;
+	byte *pvs;
+	byte *phs;
+} sv_vis_cache_entry_t;
+
+/**
+ * @brief A least-recently-used cache of client visibility, keyed by the set of
+ * clusters touched by the client's view bounds. Visibility is static for the
+ * lifetime of the map, so clients standing in the same clusters share work.
+ */
+typedef struct {
+	sv_vis_cache_entry_t entries[SV_VIS_CACHE_SIZE];
+	size_t vis_len; // bytes per row
+	byte *data; // row storage for all entries
+	uint32_t time; // LRU clock
+
+	uint32_t set_hits, set_misses; // merged cluster set lookups
+	uint32_t row_hits, row_misses; // individual cluster row lookups
+
+	SDL_SpinLock lock; // frames may be built from multiple threads
+} sv_vis_cache_t;
+
+/**
+ * @brief The number of distinct deltas cached per entity number.
+ */
+#define SV_DELTA_CACHE_WAYS 4
+
+/**
+ * @brief The largest encoded entity delta that is cached.
+ */
+#define SV_DELTA_CACHE_DATA 64
+
+/**
+ * @brief An encoded entity delta, keyed by the states and codec it was
+ * encoded with. An unused entry has a protocol of 0.
+ */
+typedef struct {
+	entity_state_t from, to;
+	int32_t protocol;
+	_Bool force;
+	uint16_t size;
+	byte data[SV_DELTA_CACHE_DATA];
+} sv_delta_cache_entry_t;
+
+/**
+ * @brief The cached deltas for a single entity number.
+ */
+typedef struct {
+	sv_delta_cache_entry_t entries[SV_DELTA_CACHE_WAYS];
+	uint32_t next; // round-robin replacement
+	SDL_SpinLock lock;
+} sv_delta_cache_bucket_t;
+
+/**
+ * @brief A cache of encoded entity deltas. Clients that acknowledged the same
+ * recent frame see the same entity state transitions, so the first client to
+ * encode a given delta each tick does so on behalf of the others.
+ */
+typedef struct {
+	sv_delta_cache_bucket_t *buckets; // one per entity number
+	SDL_atomic_t hits, misses;
+} sv_delta_cache_t;
+
+/**
+ * @brief The number of traces, and of point contents queries, memoized per tick.
+ */
+#define SV_TRACE_CACHE_SIZE 256
+
+/**
+ * @brief The arguments of a memoized Sv_Trace. Keys are zeroed before they are
+ * filled, so that they may be hashed and compared as bytes.
+ */
+typedef struct {
+	vec3_t start, end;
+	vec3_t mins, maxs;
+	const g_entity_t *skip;
+	int32_t contents;
+} sv_trace_key_t;
+
+/**
+ * @brief A memoized Sv_Trace. An entry is valid while its generation matches
+ * the current trace cache generation.
+ */
+typedef struct {
+	sv_trace_key_t key;
+	int32_t generation;
+	cm_trace_t trace;
+} sv_trace_cache_entry_t;
+
+/**
+ * @brief A memoized Sv_PointContents.
+ */
+typedef struct {
+	vec3_t point;
+	int32_t generation;
+	int32_t contents;
+} sv_point_contents_cache_entry_t;
+
+/**
+ * @brief A direct-mapped cache of trace and point contents results, enabled by
+ * `sv_trace_cache`. The game may trace from the thread pool, so each thread has
+ * a cache of its own, while the atomic generation that validates their entries
+ * is shared. The results can only change when an entity is linked or unlinked,
+ * or when a new tick begins, at which point every thread's entries are
+ * invalidated by advancing the generation. Sv_BoxEntities, which point contents
+ * and traces rely on, keeps its query on the caller's stack for the same reason.
+ */
+typedef struct {
+	sv_trace_cache_entry_t traces[SV_TRACE_CACHE_SIZE];
+	sv_point_contents_cache_entry_t point_contents[SV_TRACE_CACHE_SIZE];
+} sv_trace_cache_t;
+
+/**
+ * @brief Trace cache counters, accumulated by all threads.
+ */
+typedef struct {
+	SDL_atomic_t trace_hits, trace_misses;
+	SDL_atomic_t point_contents_hits, point_contents_misses;
+} sv_trace_cache_stats_t;
+
 /**
  * @brief Server states.
  */
@@ -69,6 +207,23 @@ typedef enum {
 	SV_ACTIVE_DEMO
 } sv_state_t;
 
+/**
+ * @brief Sv_BoxEntities and Sv_Trace counters, used to compare sector tree layouts
+ * and to see where the physics budget goes. The game may query the world from the
+ * thread pool, so these are atomic, and each query adds to them once.
+ */
+typedef struct {
+	SDL_atomic_t queries; // calls to Sv_BoxEntities
+	SDL_atomic_t sectors; // sectors visited
+	SDL_atomic_t tests; // entities tested against the query bounds
+	SDL_atomic_t entities; // entities returned
+	SDL_atomic_t rebuilds; // adaptive sector tree rebuilds
+	SDL_atomic_t frames; // calls to Sv_UpdateWorld
+	SDL_atomic_t traces; // calls to Sv_Trace
+	SDL_atomic_t candidates; // solid entities within the bounds of a trace
+	SDL_atomic_t clips; // candidates clipped to, after ownership filtering
+} sv_world_stats_t;
+
 /**
  * @brief The sv_server_t struct is wiped at each level load.
  */
@@ -87,6 +242,14 @@ typedef struct {
 	sv_entity_t entities[MAX_ENTITIES]; // the server-local entity structures
 	entity_state_t baselines[MAX_ENTITIES]; // g_entity_t baselines
 
+	sv_vis_cache_t vis_cache; // client visibility, shared by clients in the same clusters
+
+	sv_delta_cache_t delta_cache; // encoded entity deltas, shared by clients
+
+	sv_world_stats_t world_stats; // sector tree query counters
+
+	sv_trace_cache_stats_t trace_cache_stats; // trace and point contents cache hit rates
+
 	// the multicast buffer is used to send a message to a set of clients
 	// it is flushed each time Sv_Multicast is called
 	mem_buf_t multicast;
@@ -138,14 +301,20 @@ typedef enum {
  */
 #define MAX_DATAGRAM_SIZE (MAX_MSG_SIZE * 4)
 
+/**
+ * @brief The chunk size of a client's datagram message arena.
+ */
+#define SV_CLIENT_ARENA_SIZE 4096
+
 /**
  * @brief Represents the bounds of an individual client message within the
  * buffered datagram for a given frame. Datagrams are packetized along message
  * bounds and transmitted as fragments when necessary.
  */
-typedef struct {
+typedef struct sv_client_message_s {
 	size_t offset;
 	size_t len;
+	struct sv_client_message_s *next;
 } sv_client_message_t;
 
 /**
@@ -155,7 +324,8 @@ typedef struct {
 typedef struct {
 	mem_buf_t buffer; // the managed size buffer
 	byte data[MAX_DATAGRAM_SIZE]; // the raw message buffer
-	GList *messages; // message segmentation
+	sv_client_message_t *messages, *last_message; // message segmentation
+	mem_arena_t *arena; // message storage, reset with the buffer
 } sv_client_datagram_t;
 
 /**
@@ -176,6 +346,8 @@ typedef struct {
 typedef struct {
 	sv_client_state_t state;
 
+	int32_t protocol; // the PROTOCOL_MAJOR negotiated at connect
+
 	char user_info[MAX_USER_INFO_STRING]; // name, skin, etc
 
 	int32_t last_frame; // for delta compression
@@ -199,12 +371,19 @@ typedef struct {
 	// it is packetized and written to the client, then wiped, each frame.
 	sv_client_datagram_t datagram;
 
+	// the frame (player state and delta entities) is encoded here, possibly
+	// by a worker thread, before the datagram is appended and transmitted
+	mem_buf_t frame_message;
+	byte frame_message_data[MAX_MSG_SIZE];
+
 	sv_frame_t frames[PACKET_BACKUP]; // updates can be delta'd from here
 
 	sv_client_download_t download; // UDP file downloads
 
 	uint32_t last_message; // quetoo.ticks when packet was last received
 	net_chan_t net_chan;
+
+	gint64 address_key; // key into svs.client_addresses, see Sv_ClientAddressKey
 } sv_client_t;
 
 /**
@@ -230,6 +409,15 @@ typedef struct {
  */
 #define MAX_CHALLENGES 1024
 
+/**
+ * @brief Accumulated cost of Sv_SendClientPackets for ticks on which a given
+ * number of clients were sent a frame.
+ */
+typedef struct {
+	uint32_t ticks;
+	uint64_t time; // in performance counter units
+} sv_send_stats_t;
+
 /**
  * @brief The sv_static_t structure is persistent for the execution of the
  * game. It is only cleared when Sv_Init is called. It is not exposed to the
@@ -241,6 +429,7 @@ typedef struct {
 	uint32_t spawn_count; // incremented each level start, used to check late spawns
 
 	sv_client_t *clients; // server-side client structures
+	GHashTable *client_addresses; // clients by address and qport, for packet dispatch
 
 	// the server maintains an array of entity states it uses to calculate
 	// delta compression from frame to frame
@@ -249,7 +438,7 @@ typedef struct {
 	// asked to support at any point in time during the current game
 
 	uint32_t num_entity_states; // sv_max_clients->integer * UPDATE_BACKUP * MAX_PACKET_ENTITIES
-	uint32_t next_entity_state; // next entity_state to use for newly spawned entities
+	SDL_atomic_t next_entity_state; // next entity_state to use for newly spawned entities
 	entity_state_t *entity_states; // entity states array used for delta compression
 
 	net_addr_t masters[MAX_MASTERS];
@@ -257,6 +446,8 @@ typedef struct {
 
 	sv_challenge_t challenges[MAX_CHALLENGES]; // to prevent invalid IPs from connecting
 
+	sv_send_stats_t send_stats[MAX_CLIENTS + 1]; // indexed by clients sent a frame
+
 	/**
 	 * @brief The exported game module API.
 	 */
@@ -22,38 +22,57 @@
 #include "sv_local.h"
 
 /**
- * @brief The world is divided into evenly sized sectors to aid in entity
- * management. This works like a meta-BSP tree, providing fast searches via
- * recursion to find entities within an arbitrary box.
+ * @brief The world is divided into sectors to aid in entity management. This
+ * works like a meta-BSP tree, providing fast searches via recursion to find
+ * entities within an arbitrary box. By default, sectors are evenly sized. With
+ * `sv_adaptive_sectors`, they are instead split around the entities they contain.
  */
 typedef struct sv_sector_s {
 	int32_t axis; // -1 = leaf
 	vec_t dist;
 	struct sv_sector_s *children[2];
-	GList *entities;
+	uint16_t entities; // the first entity number, linked through sv_entity_t
 } sv_sector_t;
 
-#define SECTOR_DEPTH	4
-#define SECTOR_NODES	32
+#define SECTOR_DEPTH			4
+#define SECTOR_ADAPTIVE_DEPTH	6
+#define SECTOR_NODES			(1 << (SECTOR_ADAPTIVE_DEPTH + 1))
 
 /**
- * @brief The world structure contains all sectors and also the current query
- * context issued to Sv_BoxEntities.
+ * @brief Adaptive sectors containing this many entities or fewer are not split.
+ */
+#define SECTOR_ADAPTIVE_ENTITIES 4
+
+/**
+ * @brief The world structure contains all sectors and the cluster index.
  */
 typedef struct {
 	sv_sector_t sectors[SECTOR_NODES];
 	uint16_t num_sectors;
 
-	const vec_t *box_mins, *box_maxs;
+	GArray **cluster_entities; // entity numbers occupying each cluster
+	int32_t num_clusters;
 
-	g_entity_t **box_entities;
-	size_t num_box_entities, max_box_entities;
-
-	uint32_t box_type; // BOX_SOLID, BOX_TRIGGER, ..
+	GArray *top_node_entities; // entity numbers which exceed MAX_ENT_CLUSTERS
 } sv_world_t;
 
 static sv_world_t sv_world;
 
+/**
+ * @brief A query issued to Sv_BoxEntities. Each call has its own, so that the
+ * game may query the world from the thread pool.
+ */
+typedef struct {
+	const vec_t *mins, *maxs;
+
+	g_entity_t **entities;
+	size_t num_entities, max_entities;
+
+	uint32_t type; // BOX_SOLID, BOX_TRIGGER, ..
+
+	int32_t sectors, tests; // added to sv.world_stats when the query completes
+} sv_box_query_t;
+
 /**
  * @brief Builds a uniformly subdivided tree for the given world size.
  */
@@ -90,19 +109,346 @@ static sv_sector_t *Sv_CreateSector(int32_t depth, vec3_t mins, vec3_t maxs) {
 	return sector;
 }
 
+/**
+ * @brief Sorts entity numbers by their center along the axis passed as `data`.
+ */
+static gint Sv_CreateAdaptiveSector_Cmp(gconstpointer a, gconstpointer b, gpointer data) {
+
+	const int32_t axis = GPOINTER_TO_INT(data);
+
+	const g_entity_t *ea = ENTITY_FOR_NUM(*(const uint16_t *) a);
+	const g_entity_t *eb = ENTITY_FOR_NUM(*(const uint16_t *) b);
+
+	const vec_t ca = ea->abs_mins[axis] + ea->abs_maxs[axis];
+	const vec_t cb = eb->abs_mins[axis] + eb->abs_maxs[axis];
+
+	return ca < cb ? -1 : ca > cb ? 1 : 0;
+}
+
+/**
+ * @brief Builds a tree for the given world size which is split at the median
+ * of the specified entities, along the axis on which they are most spread out.
+ * Populous areas are thus subdivided more finely than empty ones.
+ *
+ * @remarks `entities` is reordered.
+ */
+static sv_sector_t *Sv_CreateAdaptiveSector(int32_t depth, vec3_t mins, vec3_t maxs,
+        uint16_t *entities, size_t num_entities) {
+
+	vec3_t center_mins, center_maxs, size;
+	vec3_t mins1, maxs1, mins2, maxs2;
+
+	sv_sector_t *sector = &sv_world.sectors[sv_world.num_sectors];
+	sv_world.num_sectors++;
+
+	sector->axis = -1;
+	sector->children[0] = sector->children[1] = NULL;
+
+	if (depth == SECTOR_ADAPTIVE_DEPTH || num_entities <= SECTOR_ADAPTIVE_ENTITIES) {
+		return sector;
+	}
+
+	ClearBounds(center_mins, center_maxs);
+
+	for (size_t i = 0; i < num_entities; i++) {
+		const g_entity_t *ent = ENTITY_FOR_NUM(entities[i]);
+		vec3_t center;
+
+		VectorLerp(ent->abs_mins, ent->abs_maxs, 0.5, center);
+		AddPointToBounds(center, center_mins, center_maxs);
+	}
+
+	VectorSubtract(center_maxs, center_mins, size);
+
+	int32_t axis = 0;
+	for (int32_t i = 1; i < 3; i++) {
+		if (size[i] > size[axis]) {
+			axis = i;
+		}
+	}
+
+	if (size[axis] == 0.0) { // all co-located, splitting would not help
+		return sector;
+	}
+
+	g_qsort_with_data(entities, (gint) num_entities, sizeof(uint16_t), Sv_CreateAdaptiveSector_Cmp,
+	                  GINT_TO_POINTER(axis));
+
+	const g_entity_t *median = ENTITY_FOR_NUM(entities[num_entities / 2]);
+	const vec_t dist = 0.5 * (median->abs_mins[axis] + median->abs_maxs[axis]);
+
+	if (dist <= mins[axis] || dist >= maxs[axis]) {
+		return sector;
+	}
+
+	sector->axis = axis;
+	sector->dist = dist;
+
+	VectorCopy(mins, mins1);
+	VectorCopy(mins, mins2);
+	VectorCopy(maxs, maxs1);
+	VectorCopy(maxs, maxs2);
+
+	maxs1[sector->axis] = mins2[sector->axis] = sector->dist;
+
+	// partition the entities by side; those crossing the split remain in this
+	// sector, and are not passed down
+	size_t back = 0, front = num_entities;
+
+	for (size_t i = 0; i < front;) {
+		const g_entity_t *ent = ENTITY_FOR_NUM(entities[i]);
+		const uint16_t e = entities[i];
+
+		if (ent->abs_maxs[axis] < dist) {
+			entities[i++] = entities[back];
+			entities[back++] = e;
+		} else if (ent->abs_mins[axis] > dist) {
+			entities[i] = entities[--front];
+			entities[front] = e;
+		} else {
+			i++;
+		}
+	}
+
+	sector->children[0] = Sv_CreateAdaptiveSector(depth + 1, mins2, maxs2, entities + front, num_entities - front);
+	sector->children[1] = Sv_CreateAdaptiveSector(depth + 1, mins1, maxs1, entities, back);
+
+	return sector;
+}
+
+/**
+ * @brief Adds the entity to the first sector that its box crosses.
+ */
+static void Sv_LinkEntitySector(g_entity_t *ent) {
+
+	sv_sector_t *sector = sv_world.sectors;
+	while (true) {
+
+		if (sector->axis == -1) {
+			break;
+		}
+
+		if (ent->abs_mins[sector->axis] > sector->dist) {
+			sector = sector->children[0];
+		} else if (ent->abs_maxs[sector->axis] < sector->dist) {
+			sector = sector->children[1];
+		} else {
+			break;    // crosses the node
+		}
+	}
+
+	const uint16_t e = NUM_FOR_ENTITY(ent);
+	sv_entity_t *sent = &sv.entities[e];
+
+	sent->sector = sector;
+	sent->sector_prev = 0;
+	sent->sector_next = sector->entities;
+
+	if (sector->entities) {
+		sv.entities[sector->entities].sector_prev = e;
+	}
+
+	sector->entities = e;
+}
+
+/**
+ * @brief The generation of valid trace cache entries, shared by all threads. This
+ * is never reset, so that entries left over from a previous level are not valid.
+ */
+static SDL_atomic_t sv_trace_cache_generation;
+
+/**
+ * @brief Each thread has its own trace cache, so that concurrent traces issued by
+ * the game through the thread pool never share entries.
+ */
+static __thread sv_trace_cache_t sv_trace_cache_entries;
+
+/**
+ * @brief Invalidates all memoized trace and point contents results, in every
+ * thread. Called whenever an entity is linked or unlinked, and as each tick begins.
+ */
+static void Sv_InvalidateTraceCache(void) {
+	SDL_AtomicIncRef(&sv_trace_cache_generation);
+}
+
 /**
  * @brief Resolve our area nodes for a newly loaded level. This is called prior to
  * linking any entities.
  */
 void Sv_InitWorld(void) {
 
-	for (uint16_t i = 0; i < sv_world.num_sectors; i++) {
-		g_list_free(sv_world.sectors[i].entities);
+	for (int32_t i = 0; i < sv_world.num_clusters; i++) {
+		g_array_free(sv_world.cluster_entities[i], true);
+	}
+
+	g_free(sv_world.cluster_entities);
+
+	if (sv_world.top_node_entities) {
+		g_array_free(sv_world.top_node_entities, true);
 	}
 
 	memset(&sv_world, 0, sizeof(sv_world));
 
 	Sv_CreateSector(0, sv.cm_models[0]->mins, sv.cm_models[0]->maxs);
+
+	sv_world.num_clusters = Cm_NumClusters();
+	sv_world.cluster_entities = g_new(GArray *, sv_world.num_clusters);
+
+	for (int32_t i = 0; i < sv_world.num_clusters; i++) {
+		sv_world.cluster_entities[i] = g_array_new(false, false, sizeof(uint16_t));
+	}
+
+	sv_world.top_node_entities = g_array_new(false, false, sizeof(uint16_t));
+
+	Sv_InvalidateTraceCache();
+}
+
+/**
+ * @brief Rebuilds the sector tree, uniform or adaptive per `sv_adaptive_sectors`,
+ * and relinks all entities to it.
+ */
+static void Sv_RebuildWorld(void) {
+	uint16_t entities[MAX_ENTITIES];
+	size_t num_entities = 0;
+
+	for (uint16_t e = 1; e < svs.game->num_entities; e++) {
+		sv_entity_t *sent = &sv.entities[e];
+
+		if (sent->sector) {
+			sent->sector = NULL;
+			entities[num_entities++] = e;
+		}
+	}
+
+	memset(sv_world.sectors, 0, sizeof(sv_world.sectors));
+	sv_world.num_sectors = 0;
+
+	const cm_bsp_model_t *world = sv.cm_models[0];
+	vec3_t mins, maxs;
+
+	VectorCopy(world->mins, mins);
+	VectorCopy(world->maxs, maxs);
+
+	if (sv_adaptive_sectors->integer) {
+		uint16_t sorted[MAX_ENTITIES];
+		memcpy(sorted, entities, num_entities * sizeof(uint16_t));
+
+		Sv_CreateAdaptiveSector(0, mins, maxs, sorted, num_entities);
+	} else {
+		Sv_CreateSector(0, mins, maxs);
+	}
+
+	for (size_t i = 0; i < num_entities; i++) {
+		Sv_LinkEntitySector(ENTITY_FOR_NUM(entities[i]));
+	}
+
+	SDL_AtomicIncRef(&sv.world_stats.rebuilds);
+}
+
+/**
+ * @brief Called each game frame, before the game module runs. Adaptive sector
+ * trees are rebuilt once per second to follow the entities they contain.
+ */
+void Sv_UpdateWorld(void) {
+
+	SDL_AtomicIncRef(&sv.world_stats.frames);
+
+	Sv_InvalidateTraceCache();
+
+	if (sv_adaptive_sectors->modified) {
+		sv_adaptive_sectors->modified = false;
+		Sv_RebuildWorld();
+	} else if (sv_adaptive_sectors->integer && (sv.frame_num % QUETOO_TICK_RATE) == 0) {
+		Sv_RebuildWorld();
+	}
+}
+
+/**
+ * @brief Removes the entity number from the specified cluster index array.
+ */
+static void Sv_RemoveClusterEntity(GArray *entities, const uint16_t e) {
+
+	for (guint i = 0; i < entities->len; i++) {
+		if (g_array_index(entities, uint16_t, i) == e) {
+			g_array_remove_index_fast(entities, i);
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Removes the entity from the cluster index.
+ */
+static void Sv_UnlinkEntityClusters(const uint16_t e) {
+
+	sv_entity_t *sent = &sv.entities[e];
+
+	if (!sent->clustered) {
+		return;
+	}
+
+	if (sent->num_clusters == -1) {
+		Sv_RemoveClusterEntity(sv_world.top_node_entities, e);
+	} else {
+		for (int32_t i = 0; i < sent->num_clusters; i++) {
+			Sv_RemoveClusterEntity(sv_world.cluster_entities[sent->clusters[i]], e);
+		}
+	}
+
+	sent->clustered = false;
+}
+
+/**
+ * @brief Adds the entity to the cluster index, so that client frames need only
+ * consider entities within visible clusters.
+ */
+static void Sv_LinkEntityClusters(const uint16_t e) {
+
+	sv_entity_t *sent = &sv.entities[e];
+
+	if (sent->num_clusters == -1) {
+		g_array_append_val(sv_world.top_node_entities, e);
+	} else {
+		for (int32_t i = 0; i < sent->num_clusters; i++) {
+			g_array_append_val(sv_world.cluster_entities[sent->clusters[i]], e);
+		}
+	}
+
+	sent->clustered = true;
+}
+
+/**
+ * @brief Marks every entity occupying a cluster in `vis`, as well as every
+ * entity which exceeds MAX_ENT_CLUSTERS, in the `entities` bit vector. This is
+ * a superset of the entities visible to `vis`, which must be further tested.
+ *
+ * @remarks `entities` must be at least `MAX_ENTITIES >> 3` in length.
+ */
+void Sv_ClusterEntities(const byte *vis, byte *entities) {
+
+	memset(entities, 0, MAX_ENTITIES >> 3);
+
+	for (guint i = 0; i < sv_world.top_node_entities->len; i++) {
+		const uint16_t e = g_array_index(sv_world.top_node_entities, uint16_t, i);
+		entities[e >> 3] |= 1 << (e & 7);
+	}
+
+	for (int32_t c = 0; c < sv_world.num_clusters; c++) {
+
+		if (vis[c >> 3] == 0) { // skip 8 clusters at a time
+			c |= 7;
+			continue;
+		}
+
+		if (vis[c >> 3] & (1 << (c & 7))) {
+			const GArray *cluster = sv_world.cluster_entities[c];
+
+			for (guint i = 0; i < cluster->len; i++) {
+				const uint16_t e = g_array_index(cluster, uint16_t, i);
+				entities[e >> 3] |= 1 << (e & 7);
+			}
+		}
+	}
 }
 
 /**
@@ -111,11 +457,25 @@ void Sv_InitWorld(void) {
  */
 void Sv_UnlinkEntity(g_entity_t *ent) {
 
-	sv_entity_t *sent = &sv.entities[NUM_FOR_ENTITY(ent)];
+	const uint16_t e = NUM_FOR_ENTITY(ent);
+	sv_entity_t *sent = &sv.entities[e];
+
+	Sv_InvalidateTraceCache(); // Sv_LinkEntity relies on this, too
+
+	Sv_UnlinkEntityClusters(e);
 
 	if (sent->sector) {
 		sv_sector_t *sector = (sv_sector_t *) sent->sector;
-		sector->entities = g_list_remove(sector->entities, ent);
+
+		if (sent->sector_prev) {
+			sv.entities[sent->sector_prev].sector_next = sent->sector_next;
+		} else {
+			sector->entities = sent->sector_next;
+		}
+
+		if (sent->sector_next) {
+			sv.entities[sent->sector_next].sector_prev = sent->sector_prev;
+		}
 
 		memset(sent, 0, sizeof(*sent));
 	}
@@ -215,30 +575,15 @@ void Sv_LinkEntity(g_entity_t *ent) {
 		}
 	}
 
+	// add it to the cluster index for frame building
+	Sv_LinkEntityClusters(NUM_FOR_ENTITY(ent));
+
 	if (ent->solid == SOLID_NOT) {
 		return;
 	}
 
-	// find the first sector that the ent's box crosses
-	sv_sector_t *sector = sv_world.sectors;
-	while (true) {
-
-		if (sector->axis == -1) {
-			break;
-		}
-
-		if (ent->abs_mins[sector->axis] > sector->dist) {
-			sector = sector->children[0];
-		} else if (ent->abs_maxs[sector->axis] < sector->dist) {
-			sector = sector->children[1];
-		} else {
-			break;    // crosses the node
-		}
-	}
-
-	// add it to the sector
-	sent->sector = sector;
-	sector->entities = g_list_prepend(sector->entities, ent);
+	// add it to the sector tree
+	Sv_LinkEntitySector(ent);
 
 	// and update its clipping matrices
 	const vec_t *angles = ent->solid == SOLID_BSP ? ent->s.angles : vec3_origin;
@@ -248,14 +593,14 @@ void Sv_LinkEntity(g_entity_t *ent) {
 }
 
 /**
- * @return True if the entity matches the current world filter, false otherwise.
+ * @return True if the entity matches the query's filter, false otherwise.
  */
-static _Bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
+static _Bool Sv_BoxEntities_Filter(const sv_box_query_t *query, const g_entity_t *ent) {
 
 	switch (ent->solid) {
 		case SOLID_TRIGGER:
 		case SOLID_PROJECTILE:
-			if (sv_world.box_type & BOX_OCCUPY) {
+			if (query->type & BOX_OCCUPY) {
 				return true;
 			}
 			break;
@@ -263,7 +608,7 @@ static _Bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
 		case SOLID_DEAD:
 		case SOLID_BOX:
 		case SOLID_BSP:
-			if (sv_world.box_type & BOX_COLLIDE) {
+			if (query->type & BOX_COLLIDE) {
 				return true;
 			}
 			break;
@@ -278,27 +623,28 @@ static _Bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
 /**
  * @brief
  */
-static void Sv_BoxEntities_r(sv_sector_t *sector) {
+static void Sv_BoxEntities_r(sv_box_query_t *query, const sv_sector_t *sector) {
+
+	query->sectors++;
+
+	for (uint16_t e = sector->entities; e; e = sv.entities[e].sector_next) {
+		g_entity_t *ent = ENTITY_FOR_NUM(e);
 
-	GList *e = sector->entities;
-	while (e) {
-		g_entity_t *ent = (g_entity_t *) e->data;
+		if (Sv_BoxEntities_Filter(query, ent)) {
 
-		if (Sv_BoxEntities_Filter(ent)) {
+			query->tests++;
 
-			if (BoxIntersect(ent->abs_mins, ent->abs_maxs, sv_world.box_mins, sv_world.box_maxs)) {
+			if (BoxIntersect(ent->abs_mins, ent->abs_maxs, query->mins, query->maxs)) {
 
-				sv_world.box_entities[sv_world.num_box_entities] = ent;
-				sv_world.num_box_entities++;
+				query->entities[query->num_entities] = ent;
+				query->num_entities++;
 
-				if (sv_world.num_box_entities == sv_world.max_box_entities) {
-					Com_Warn("sv_world.max_box_entities reached\n");
+				if (query->num_entities == query->max_entities) {
+					Com_Warn("max_entities reached\n");
 					return;
 				}
 			}
 		}
-
-		e = e->next;
 	}
 
 	if (sector->axis == -1) {
@@ -306,12 +652,12 @@ static void Sv_BoxEntities_r(sv_sector_t *sector) {
 	}
 
 	// recurse down both sides
-	if (sv_world.box_maxs[sector->axis] > sector->dist) {
-		Sv_BoxEntities_r(sector->children[0]);
+	if (query->maxs[sector->axis] > sector->dist) {
+		Sv_BoxEntities_r(query, sector->children[0]);
 	}
 
-	if (sv_world.box_mins[sector->axis] < sector->dist) {
-		Sv_BoxEntities_r(sector->children[1]);
+	if (query->mins[sector->axis] < sector->dist) {
+		Sv_BoxEntities_r(query, sector->children[1]);
 	}
 }
 
@@ -325,27 +671,36 @@ static void Sv_BoxEntities_r(sv_sector_t *sector) {
 size_t Sv_BoxEntities(const vec3_t mins, const vec3_t maxs, g_entity_t **list, const size_t len,
                       const uint32_t type) {
 
-	sv_world.box_mins = mins;
-	sv_world.box_maxs = maxs;
-	sv_world.box_entities = list;
-	sv_world.num_box_entities = 0;
-	sv_world.max_box_entities = len;
-	sv_world.box_type = type;
+	sv_box_query_t query = {
+		.mins = mins,
+		.maxs = maxs,
+		.entities = list,
+		.max_entities = len,
+		.type = type
+	};
+
+	Sv_BoxEntities_r(&query, sv_world.sectors);
 
-	Sv_BoxEntities_r(sv_world.sectors);
+	sv_world_stats_t *stats = &sv.world_stats;
 
-	sv_world.box_mins = vec3_origin;
-	sv_world.box_maxs = vec3_origin;
-	sv_world.box_entities = NULL;
+	SDL_AtomicIncRef(&stats->queries);
+	SDL_AtomicAdd(&stats->sectors, query.sectors);
+	SDL_AtomicAdd(&stats->tests, query.tests);
+	SDL_AtomicAdd(&stats->entities, (int32_t) query.num_entities);
 
-	return sv_world.num_box_entities;
+	return query.num_entities;
 }
 
 /**
  * @brief Prepares the collision model to clip to the specified entity. For
- * mesh models, the box hull must be set to reflect the bounds of the entity.
+ * mesh models, the box hull is initialized to reflect the bounds of the entity.
+ *
+ * @param head_node The head node of the entity's inline BSP model, or -1 for the box hull.
+ * @param hull The box hull, which is private to the caller.
+ *
+ * @return True if the entity may be clipped to, false otherwise.
  */
-static int32_t Sv_HullForEntity(const g_entity_t *ent) {
+static _Bool Sv_HullForEntity(const g_entity_t *ent, int32_t *head_node, cm_box_hull_t *hull) {
 
 	if (ent->solid == SOLID_BSP) {
 		const cm_bsp_model_t *mod = sv.cm_models[ent->s.model1];
@@ -354,23 +709,43 @@ static int32_t Sv_HullForEntity(const g_entity_t *ent) {
 			Com_Error(ERROR_DROP, "SOLID_BSP with no model\n");
 		}
 
-		return mod->head_node;
+		*head_node = mod->head_node;
+		return true;
 	}
 
+	*head_node = -1;
+
 	if (ent->solid == SOLID_BOX) {
 
 		if (ent->client) {
-			return Cm_SetBoxHull(ent->mins, ent->maxs, CONTENTS_MONSTER);
+			Cm_InitBoxHull(hull, ent->mins, ent->maxs, CONTENTS_MONSTER);
+		} else {
+			Cm_InitBoxHull(hull, ent->mins, ent->maxs, CONTENTS_SOLID);
 		}
 
-		return Cm_SetBoxHull(ent->mins, ent->maxs, CONTENTS_SOLID);
+		return true;
 	}
 
 	if (ent->solid == SOLID_DEAD) {
-		return Cm_SetBoxHull(ent->mins, ent->maxs, CONTENTS_DEAD_MONSTER);
+		Cm_InitBoxHull(hull, ent->mins, ent->maxs, CONTENTS_DEAD_MONSTER);
+		return true;
 	}
 
-	return -1;
+	return false;
+}
+
+/**
+ * @return A hash code for the specified trace or point contents query.
+ */
+static uint32_t Sv_HashTraceQuery(const void *query, const size_t size) {
+	const uint32_t *words = query;
+	uint32_t hash = 5381;
+
+	for (size_t i = 0; i < size / sizeof(uint32_t); i++) {
+		hash = hash * 33 + words[i];
+	}
+
+	return hash;
 }
 
 /**
@@ -380,6 +755,24 @@ static int32_t Sv_HullForEntity(const g_entity_t *ent) {
 int32_t Sv_PointContents(const vec3_t point) {
 	g_entity_t *entities[MAX_ENTITIES];
 
+	sv_trace_cache_stats_t *stats = &sv.trace_cache_stats;
+	sv_point_contents_cache_entry_t *entry = NULL;
+
+	const int32_t generation = SDL_AtomicGet(&sv_trace_cache_generation);
+
+	if (sv_trace_cache->integer) {
+		const uint32_t hash = Sv_HashTraceQuery(point, sizeof(vec3_t));
+
+		entry = &sv_trace_cache_entries.point_contents[hash % SV_TRACE_CACHE_SIZE];
+
+		if (entry->generation == generation && VectorCompare(entry->point, point)) {
+			SDL_AtomicIncRef(&stats->point_contents_hits);
+			return entry->contents;
+		}
+
+		SDL_AtomicIncRef(&stats->point_contents_misses);
+	}
+
 	// get base contents from world
 	int32_t contents = Cm_PointContents(point, 0);
 
@@ -390,14 +783,22 @@ int32_t Sv_PointContents(const vec3_t point) {
 	for (size_t i = 0; i < len; i++) {
 		const g_entity_t *ent = entities[i];
 
-		const int32_t head_node = Sv_HullForEntity(ent);
-		if (head_node != -1) {
+		int32_t head_node;
+		cm_box_hull_t hull;
+
+		if (Sv_HullForEntity(ent, &head_node, &hull)) {
 
 			const sv_entity_t *sent = &sv.entities[NUM_FOR_ENTITY(ent)];
-			contents |= Cm_TransformedPointContents(point, head_node, &sent->inverse_matrix);
+			contents |= Cm_TransformedPointContents(point, head_node, &hull, &sent->inverse_matrix);
 		}
 	}
 
+	if (entry) {
+		VectorCopy(point, entry->point);
+		entry->generation = generation;
+		entry->contents = contents;
+	}
+
 	return contents;
 }
 
@@ -409,58 +810,86 @@ typedef struct {
 	cm_trace_t trace;
 	const g_entity_t *skip;
 	int32_t contents;
+	int32_t candidates, clips; // added to sv.world_stats when the trace completes
 } sv_trace_t;
 
 /**
- * @brief Clips the specified trace to other entities in its area. This is the basis of all
- * collision and interaction for the server. Tread carefully.
+ * @return True if the trace should skip the specified entity, false otherwise.
  */
-static void Sv_ClipTraceToEntities(sv_trace_t *trace) {
-	g_entity_t *e[MAX_ENTITIES];
+static _Bool Sv_ClipTraceToEntity_Skip(const sv_trace_t *trace, const g_entity_t *ent) {
 
-	const size_t len = Sv_BoxEntities(trace->box_mins, trace->box_maxs, e, lengthof(e), BOX_COLLIDE);
+	if (trace->skip) { // see if we can skip it
 
-	for (size_t i = 0; i < len; i++) {
-		g_entity_t *ent = e[i];
+		if (ent == trace->skip) {
+			return true;    // explicitly (ourselves)
+		}
 
-		if (trace->skip) { // see if we can skip it
+		if (ent->owner == trace->skip) {
+			return true;    // or via ownership (we own it)
+		}
 
-			if (ent == trace->skip) {
-				continue;    // explicitly (ourselves)
+		if (trace->skip->owner) {
+
+			if (ent == trace->skip->owner) {
+				return true;    // which is bidirectional (inverse of previous case)
 			}
 
-			if (ent->owner == trace->skip) {
-				continue;    // or via ownership (we own it)
+			if (ent->owner == trace->skip->owner) {
+				return true;    // and commutative (we are both owned by the same)
 			}
+		}
 
-			if (trace->skip->owner) {
+		// triggers only clip to the world (while other entities can occupy triggers)
+		if (trace->skip->solid == SOLID_TRIGGER) {
 
-				if (ent == trace->skip->owner) {
-					continue;    // which is bidirectional (inverse of previous case)
-				}
-
-				if (ent->owner == trace->skip->owner) {
-					continue;    // and commutative (we are both owned by the same)
-				}
+			if (ent->solid != SOLID_BSP) {
+				return true;
 			}
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Clips the specified trace to the entities in the given sector and its
+ * children. The sector tree is walked in the order of Sv_BoxEntities, but no
+ * list of entities is gathered. This is the basis of all collision and
+ * interaction for the server. Tread carefully.
+ *
+ * @return True if the trace was blocked entirely, false otherwise.
+ */
+static _Bool Sv_ClipTraceToEntities_r(sv_trace_t *trace, const sv_sector_t *sector) {
 
-			// triggers only clip to the world (while other entities can occupy triggers)
-			if (trace->skip->solid == SOLID_TRIGGER) {
+	for (uint16_t e = sector->entities; e; e = sv.entities[e].sector_next) {
+		g_entity_t *ent = ENTITY_FOR_NUM(e);
 
-				if (ent->solid != SOLID_BSP) {
-					continue;
-				}
-			}
+		if (ent->solid != SOLID_BOX && ent->solid != SOLID_BSP && ent->solid != SOLID_DEAD) {
+			continue;
 		}
 
-		const int32_t head_node = Sv_HullForEntity(ent);
-		if (head_node != -1) {
+		if (!BoxIntersect(ent->abs_mins, ent->abs_maxs, trace->box_mins, trace->box_maxs)) {
+			continue;
+		}
 
-			const sv_entity_t *sent = &sv.entities[NUM_FOR_ENTITY(ent)];
+		trace->candidates++;
+
+		if (Sv_ClipTraceToEntity_Skip(trace, ent)) {
+			continue;
+		}
+
+		int32_t head_node;
+		cm_box_hull_t hull;
+
+		if (Sv_HullForEntity(ent, &head_node, &hull)) {
+
+			trace->clips++;
+
+			const sv_entity_t *sent = &sv.entities[e];
 
 			const cm_trace_t tr = Cm_TransformedBoxTrace(
-			                          trace->start, trace->end, trace->mins, trace->maxs, head_node, trace->contents,
-			                          &sent->matrix, &sent->inverse_matrix);
+			                          trace->start, trace->end, trace->mins, trace->maxs, head_node, &hull,
+			                          trace->contents, &sent->matrix, &sent->inverse_matrix);
 
 			// check for a full or partial intersection
 			if (tr.all_solid || tr.fraction < trace->trace.fraction) {
@@ -469,11 +898,61 @@ static void Sv_ClipTraceToEntities(sv_trace_t *trace) {
 				trace->trace.ent = ent;
 
 				if (tr.all_solid) { // we were actually blocked
-					return;
+					return true;
 				}
 			}
 		}
 	}
+
+	if (sector->axis == -1) {
+		return false;    // terminal node
+	}
+
+	// recurse down both sides
+	if (trace->box_maxs[sector->axis] > sector->dist) {
+		if (Sv_ClipTraceToEntities_r(trace, sector->children[0])) {
+			return true;
+		}
+	}
+
+	if (trace->box_mins[sector->axis] < sector->dist) {
+		if (Sv_ClipTraceToEntities_r(trace, sector->children[1])) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Clips the specified trace to other entities in its area.
+ */
+static void Sv_ClipTraceToEntities(sv_trace_t *trace) {
+
+	Sv_ClipTraceToEntities_r(trace, sv_world.sectors);
+
+	SDL_AtomicAdd(&sv.world_stats.candidates, trace->candidates);
+	SDL_AtomicAdd(&sv.world_stats.clips, trace->clips);
+}
+
+/**
+ * @brief Memoizes the trace in the specified cache entry, if any.
+ *
+ * @param generation The generation read before the trace was performed, so that
+ * a result computed while another thread invalidated the cache is not kept.
+ *
+ * @return The trace.
+ */
+static cm_trace_t Sv_CacheTrace(sv_trace_cache_entry_t *entry, int32_t generation,
+                                const sv_trace_key_t *key, const cm_trace_t *trace) {
+
+	if (entry) {
+		memcpy(&entry->key, key, sizeof(*key));
+		entry->generation = generation;
+		entry->trace = *trace;
+	}
+
+	return *trace;
 }
 
 /**
@@ -489,6 +968,8 @@ cm_trace_t Sv_Trace(const vec3_t start, const vec3_t end, const vec3_t mins, con
 
 	memset(&trace, 0, sizeof(trace));
 
+	SDL_AtomicIncRef(&sv.world_stats.traces);
+
 	if (!mins) {
 		mins = vec3_origin;
 	}
@@ -496,13 +977,41 @@ cm_trace_t Sv_Trace(const vec3_t start, const vec3_t end, const vec3_t mins, con
 		maxs = vec3_origin;
 	}
 
+	sv_trace_cache_stats_t *stats = &sv.trace_cache_stats;
+	sv_trace_cache_entry_t *entry = NULL;
+	sv_trace_key_t key;
+
+	const int32_t generation = SDL_AtomicGet(&sv_trace_cache_generation);
+
+	if (sv_trace_cache->integer) {
+
+		memset(&key, 0, sizeof(key));
+
+		VectorCopy(start, key.start);
+		VectorCopy(end, key.end);
+		VectorCopy(mins, key.mins);
+		VectorCopy(maxs, key.maxs);
+
+		key.skip = skip;
+		key.contents = contents;
+
+		entry = &sv_trace_cache_entries.traces[Sv_HashTraceQuery(&key, sizeof(key)) % SV_TRACE_CACHE_SIZE];
+
+		if (entry->generation == generation && !memcmp(&entry->key, &key, sizeof(key))) {
+			SDL_AtomicIncRef(&stats->trace_hits);
+			return entry->trace;
+		}
+
+		SDL_AtomicIncRef(&stats->trace_misses);
+	}
+
 	// clip to world
 	trace.trace = Cm_BoxTrace(start, end, mins, maxs, 0, contents);
 	if (trace.trace.fraction < 1.0) {
 		trace.trace.ent = svs.game->entities;
 
 		if (trace.trace.start_solid) { // blocked entirely
-			return trace.trace;
+			return Sv_CacheTrace(entry, generation, &key, &trace.trace);
 		}
 	}
 
@@ -519,5 +1028,5 @@ cm_trace_t Sv_Trace(const vec3_t start, const vec3_t end, const vec3_t mins, con
 	// clip to other solid entities
 	Sv_ClipTraceToEntities(&trace);
 
-	return trace.trace;
+	return Sv_CacheTrace(entry, generation, &key, &trace.trace);
 }
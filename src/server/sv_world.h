@@ -25,8 +25,10 @@
 
 #ifdef __SV_LOCAL_H__
 void Sv_InitWorld(void);
+void Sv_UpdateWorld(void);
 void Sv_LinkEntity(g_entity_t *ent);
 void Sv_UnlinkEntity(g_entity_t *ent);
+void Sv_ClusterEntities(const byte *vis, byte *entities);
 size_t Sv_BoxEntities(const vec3_t mins, const vec3_t maxs, g_entity_t **list, const size_t len,
                       const uint32_t type);
 int32_t Sv_PointContents(const vec3_t p);
@@ -0,0 +1,254 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "collision/cmodel.h"
+#include "filesystem.h"
+#include "thread.h"
+
+quetoo_t quetoo;
+
+#define NUM_TRACES 10000
+#define NUM_ITERATIONS 10
+#define NUM_BENCHMARK_TRACES 100000
+
+/**
+ * @brief The arguments and results of a single query.
+ */
+typedef struct {
+	vec3_t start, end;
+	vec3_t mins, maxs;
+	vec3_t hull_origin, hull_mins, hull_maxs;
+
+	cm_trace_t world, hull;
+	int32_t contents;
+} query_t;
+
+static query_t serial[NUM_TRACES], concurrent[NUM_TRACES];
+
+static const cm_bsp_model_t *world;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	Fs_Init(FS_AUTO_LOAD_ARCHIVES);
+
+	Thread_Init(4);
+
+	world = Cm_LoadBspModel("maps/torn.bsp", NULL);
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	Cm_LoadBspModel(NULL, NULL);
+
+	Thread_Shutdown();
+
+	Fs_Shutdown();
+
+	Mem_Shutdown();
+}
+
+/**
+ * @brief Runs the query against the world and a box hull of its own.
+ */
+static void query(query_t *q) {
+	matrix4x4_t matrix, inverse_matrix;
+	cm_box_hull_t hull;
+
+	q->world = Cm_BoxTrace(q->start, q->end, q->mins, q->maxs, 0, MASK_CLIP_PLAYER);
+
+	Cm_InitBoxHull(&hull, q->hull_mins, q->hull_maxs, CONTENTS_MONSTER);
+
+	Matrix4x4_CreateTranslate(&matrix, q->hull_origin[0], q->hull_origin[1], q->hull_origin[2]);
+	Matrix4x4_Invert_Simple(&inverse_matrix, &matrix);
+
+	q->hull = Cm_TransformedBoxTrace(q->start, q->end, q->mins, q->maxs, -1, &hull,
+	                                 MASK_CLIP_PLAYER, &matrix, &inverse_matrix);
+
+	q->contents = Cm_PointContents(q->end, 0);
+}
+
+/**
+ * @brief ThreadRangeFunc for check_Cm_BoxTrace.
+ */
+static void query_range(size_t start, size_t end, void *data) {
+
+	for (size_t i = start; i < end; i++) {
+		query(&concurrent[i]);
+	}
+}
+
+/**
+ * @brief Asserts that the traces are identical.
+ */
+static void compare(const cm_trace_t *a, const cm_trace_t *b) {
+
+	ck_assert_int_eq(a->all_solid, b->all_solid);
+	ck_assert_int_eq(a->start_solid, b->start_solid);
+	ck_assert(a->fraction == b->fraction);
+	ck_assert(VectorCompare(a->end, b->end));
+	ck_assert(VectorCompare(a->plane.normal, b->plane.normal));
+	ck_assert(a->plane.dist == b->plane.dist);
+	ck_assert(a->surface == b->surface);
+	ck_assert_int_eq(a->contents, b->contents);
+}
+
+START_TEST(check_Cm_BoxTrace) {
+
+	for (int32_t i = 0; i < NUM_TRACES; i++) {
+		query_t *q = &serial[i];
+
+		memset(q, 0, sizeof(*q));
+
+		for (int32_t j = 0; j < 3; j++) {
+			q->start[j] = Randomfr(world->mins[j], world->maxs[j]);
+			q->end[j] = q->start[j] + Randomfr(-256.0, 256.0);
+
+			if (i & 1) { // half of the traces are boxes
+				q->mins[j] = -Randomfr(1.0, 32.0);
+				q->maxs[j] = Randomfr(1.0, 32.0);
+			}
+
+			q->hull_origin[j] = q->start[j] + Randomfr(-128.0, 128.0);
+			q->hull_mins[j] = -Randomfr(8.0, 64.0);
+			q->hull_maxs[j] = Randomfr(8.0, 64.0);
+		}
+
+		if (i % 10 == 0) { // and some are position tests
+			VectorCopy(q->start, q->end);
+		}
+
+		query(q);
+	}
+
+	// run the same queries concurrently, with each thread using its own box hulls
+	for (int32_t i = 0; i < NUM_ITERATIONS; i++) {
+
+		for (int32_t j = 0; j < NUM_TRACES; j++) {
+			concurrent[j] = serial[j];
+			memset(&concurrent[j].world, 0, sizeof(cm_trace_t));
+			memset(&concurrent[j].hull, 0, sizeof(cm_trace_t));
+			concurrent[j].contents = -1;
+		}
+
+		Thread_ParallelFor(NUM_TRACES, 16, query_range, NULL);
+
+		for (int32_t j = 0; j < NUM_TRACES; j++) {
+			compare(&serial[j].world, &concurrent[j].world);
+			compare(&serial[j].hull, &concurrent[j].hull);
+			ck_assert_int_eq(serial[j].contents, concurrent[j].contents);
+		}
+	}
+
+	Com_Print("Cm_BoxTrace: %d queries on %d threads matched the serial run\n",
+	          NUM_TRACES * NUM_ITERATIONS, Thread_Count());
+
+} END_TEST
+
+static vec3_t starts[NUM_BENCHMARK_TRACES], ends[NUM_BENCHMARK_TRACES];
+static cm_trace_t traces[NUM_BENCHMARK_TRACES], batch_traces[NUM_BENCHMARK_TRACES];
+
+/**
+ * @brief Measures the throughput of Cm_BoxTrace and Cm_BoxTraceBatch over the
+ * same traces, and asserts that their results are identical.
+ */
+static void benchmark(const vec3_t mins, const vec3_t maxs) {
+
+	gint64 start = g_get_monotonic_time();
+
+	for (int32_t i = 0; i < NUM_BENCHMARK_TRACES; i++) {
+		traces[i] = Cm_BoxTrace(starts[i], ends[i], mins, maxs, 0, MASK_CLIP_PLAYER);
+	}
+
+	const gint64 trace_time = g_get_monotonic_time() - start;
+
+	start = g_get_monotonic_time();
+
+	Cm_BoxTraceBatch((const vec3_t *) starts, (const vec3_t *) ends, mins, maxs,
+	                 NUM_BENCHMARK_TRACES, 0, MASK_CLIP_PLAYER, batch_traces);
+
+	const gint64 batch_time = g_get_monotonic_time() - start;
+
+	for (int32_t i = 0; i < NUM_BENCHMARK_TRACES; i++) {
+		compare(&traces[i], &batch_traces[i]);
+	}
+
+	Com_Print("%s: Cm_BoxTrace %.0f, Cm_BoxTraceBatch %.0f traces per ms\n",
+	          VectorCompare(mins, maxs) ? "point" : "box",
+	          NUM_BENCHMARK_TRACES / (Max(trace_time, (gint64) 1) / 1000.0),
+	          NUM_BENCHMARK_TRACES / (Max(batch_time, (gint64) 1) / 1000.0));
+}
+
+START_TEST(check_Cm_BoxTraceBatch) {
+
+	// coherent bundles, as cast from one light to neighboring samples, or by
+	// particles and reachability tests around one entity
+	for (int32_t i = 0; i < NUM_BENCHMARK_TRACES; i += CM_TRACE_PACKET) {
+		vec3_t start, end;
+
+		for (int32_t j = 0; j < 3; j++) {
+			start[j] = Randomfr(world->mins[j], world->maxs[j]);
+			end[j] = start[j] + Randomfr(-512.0, 512.0);
+		}
+
+		for (int32_t j = i; j < i + CM_TRACE_PACKET && j < NUM_BENCHMARK_TRACES; j++) {
+			VectorCopy(start, starts[j]);
+
+			for (int32_t k = 0; k < 3; k++) {
+				ends[j][k] = end[k] + Randomfr(-16.0, 16.0);
+			}
+		}
+	}
+
+	benchmark(vec3_origin, vec3_origin);
+	benchmark((const vec3_t) { -16.0, -16.0, -24.0 }, (const vec3_t) { 16.0, 16.0, 32.0 });
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_cm_trace");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Cm_BoxTrace);
+	tcase_add_test(tcase, check_Cm_BoxTraceBatch);
+
+	Suite *suite = suite_create("check_cm_trace");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
@@ -72,6 +72,125 @@ START_TEST(check_Mem_CopyString) {
 	ck_assert(Mem_Size() == 0);
 } END_TEST
 
+START_TEST(check_Mem_Realloc) {
+	byte *parent = Mem_TagMalloc(1, MEM_TAG_GAME);
+
+	byte *child = Mem_LinkMalloc(1, parent);
+	*child = 1;
+
+	child = Mem_Realloc(child, 4);
+	ck_assert(Mem_Size() == 5);
+	ck_assert(*child == 1);
+
+	parent = Mem_Realloc(parent, 1024 * 1024);
+	ck_assert(Mem_Size() == 1024 * 1024 + 4);
+
+	Mem_FreeTag(MEM_TAG_GAME);
+
+	ck_assert(Mem_Size() == 0);
+
+} END_TEST
+
+START_TEST(check_Mem_Arena) {
+	mem_arena_t *arena = Mem_CreateArena(64, MEM_TAG_GAME);
+
+	const size_t size = Mem_Size();
+
+	for (int32_t i = 0; i < 2; i++) {
+
+		byte *a = Mem_ArenaMalloc(arena, 1);
+		byte *b = Mem_ArenaMalloc(arena, 1);
+
+		ck_assert(((uintptr_t) a & 15) == 0);
+		ck_assert(b == a + 16);
+
+		byte *c = Mem_ArenaMalloc(arena, 256);
+		ck_assert(*c == 0 && c[255] == 0);
+
+		memset(c, 0xff, 256);
+
+		Mem_ResetArena(arena);
+	}
+
+	// once grown, the arena satisfies the same allocations without growing again
+	ck_assert(Mem_Size() > size);
+
+	const size_t grown = Mem_Size();
+
+	Mem_ArenaMalloc(arena, 1);
+	Mem_ArenaMalloc(arena, 256);
+
+	ck_assert(Mem_Size() == grown);
+
+	Mem_FreeTag(MEM_TAG_GAME);
+
+	ck_assert(Mem_Size() == 0);
+
+} END_TEST
+
+#define NUM_ALLOCATIONS 1000000
+#define NUM_LIVE_ALLOCATIONS 256
+
+/**
+ * @brief GThreadFunc for check_Mem_Malloc. Allocates, links and frees blocks
+ * of assorted sizes, as the tools and game modules do.
+ */
+static gpointer check_Mem_Malloc_Thread(gpointer data) {
+	byte *live[NUM_LIVE_ALLOCATIONS] = { NULL };
+
+	const int32_t count = GPOINTER_TO_INT(data);
+
+	for (int32_t i = 0; i < count; i++) {
+		const int32_t j = Random() % NUM_LIVE_ALLOCATIONS;
+
+		if (live[j]) {
+			Mem_Free(live[j]);
+			live[j] = NULL;
+		} else {
+			const size_t size = Random() % 100 ? Randomr(1, 512) : Randomr(1, 64 * 1024);
+
+			if (j && live[j - 1] && (i & 1)) {
+				Mem_LinkMalloc(size, live[j - 1]);
+			} else {
+				live[j] = Mem_TagMalloc(size, MEM_TAG_GAME);
+			}
+		}
+	}
+
+	for (int32_t i = 0; i < NUM_LIVE_ALLOCATIONS; i++) {
+		Mem_Free(live[i]);
+	}
+
+	return NULL;
+}
+
+START_TEST(check_Mem_Malloc) {
+	const int32_t num_threads[] = { 1, 4, 16 };
+
+	for (size_t i = 0; i < lengthof(num_threads); i++) {
+		GThread *threads[16];
+
+		const int32_t n = num_threads[i];
+		const gint64 start = g_get_monotonic_time();
+
+		for (int32_t j = 0; j < n; j++) {
+			threads[j] = g_thread_new(__func__, check_Mem_Malloc_Thread, GINT_TO_POINTER(NUM_ALLOCATIONS / n));
+		}
+
+		for (int32_t j = 0; j < n; j++) {
+			g_thread_join(threads[j]);
+		}
+
+		const gint64 time = g_get_monotonic_time() - start;
+
+		ck_assert(Mem_Size() == 0);
+
+		Com_Print("Mem_Malloc: %d threads, %d operations in %" PRId64 "ms (%.0f/s)\n", n,
+		          NUM_ALLOCATIONS, (int64_t) (time / 1000), NUM_ALLOCATIONS * 1000000.0 / MAX(time, 1));
+	}
+
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -84,6 +203,9 @@ int32_t main(int32_t argc, char **argv) {
 
 	tcase_add_test(tcase, check_Mem_LinkMalloc);
 	tcase_add_test(tcase, check_Mem_CopyString);
+	tcase_add_test(tcase, check_Mem_Realloc);
+	tcase_add_test(tcase, check_Mem_Arena);
+	tcase_add_test(tcase, check_Mem_Malloc);
 
 	Suite *suite = suite_create("check_mem");
 	suite_add_tcase(suite, tcase);
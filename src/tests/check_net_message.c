@@ -0,0 +1,212 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "net/net_types.h"
+#include "net/net_message.h"
+
+quetoo_t quetoo;
+
+#define NUM_FRAMES 1000
+
+static mem_buf_t message;
+static byte message_buffer[MAX_MSG_SIZE];
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	Mem_InitBuffer(&message, message_buffer, sizeof(message_buffer));
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	Mem_Shutdown();
+}
+
+START_TEST(check_Net_WriteBits) {
+	net_bits_t bits;
+
+	Net_BeginBits(&message, &bits);
+
+	Net_WriteBits(&bits, 1, 1);
+	Net_WriteBits(&bits, 5, 3);
+	Net_WriteSignedBits(&bits, -1000, 12);
+	Net_WriteBits(&bits, 0xdeadbeef, 32);
+	Net_FlushBits(&bits);
+
+	Net_WriteByte(&message, 0x7f);
+
+	Net_WriteVarint(&message, 0);
+	Net_WriteVarint(&message, 0x7f);
+	Net_WriteVarint(&message, 0x80);
+	Net_WriteVarint(&message, 0xffffffff);
+
+	ck_assert_int_eq(message.size, 6 + 1 + 1 + 1 + 2 + 5);
+
+	Net_BeginReading(&message);
+	Net_BeginBits(&message, &bits);
+
+	ck_assert_uint_eq(Net_ReadBits(&bits, 1), 1);
+	ck_assert_uint_eq(Net_ReadBits(&bits, 3), 5);
+	ck_assert_int_eq(Net_ReadSignedBits(&bits, 12), -1000);
+	ck_assert_uint_eq(Net_ReadBits(&bits, 32), 0xdeadbeef);
+
+	ck_assert_int_eq(Net_ReadByte(&message), 0x7f);
+
+	ck_assert_uint_eq(Net_ReadVarint(&message), 0);
+	ck_assert_uint_eq(Net_ReadVarint(&message), 0x7f);
+	ck_assert_uint_eq(Net_ReadVarint(&message), 0x80);
+	ck_assert_uint_eq(Net_ReadVarint(&message), 0xffffffff);
+
+	ck_assert_int_eq(message.read, message.size);
+
+} END_TEST
+
+/**
+ * @brief Moves the entity by a random amount, occasionally teleporting it.
+ */
+static void move(entity_state_t *s) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		if (Randomr(0, 50) == 0) {
+			s->origin[i] = Randomfr(-MAX_WORLD_COORD, MAX_WORLD_COORD);
+		} else {
+			s->origin[i] += Randomfr(-32.0, 32.0);
+		}
+	}
+
+	s->angles[YAW] = Randomfr(0.0, 360.0);
+	s->animation1 = Randomr(0, 64);
+}
+
+/**
+ * @brief Delta encodes a moving entity against the previously decoded state,
+ * as the server and client do, and ensures that the decoded state does not
+ * drift from the original.
+ */
+static size_t check_Net_WriteDeltaEntity_protocol(const int32_t protocol, const vec_t epsilon) {
+	entity_state_t from, to, read_from, read_to;
+
+	memset(&from, 0, sizeof(from));
+	from.number = 1;
+
+	read_from = from;
+
+	size_t size = 0;
+
+	for (int32_t i = 0; i < NUM_FRAMES; i++) {
+
+		to = from;
+		move(&to);
+
+		Mem_ClearBuffer(&message);
+		Net_WriteDeltaEntity(&message, &from, &to, false, protocol);
+
+		size += message.size;
+
+		Net_BeginReading(&message);
+
+		const uint16_t number = Net_ReadShort(&message);
+		const uint16_t bits = Net_ReadDeltaEntityBits(&message, protocol);
+
+		Net_ReadDeltaEntity(&message, &read_from, &read_to, number, bits, protocol);
+
+		ck_assert_int_eq(message.read, message.size);
+		ck_assert_int_eq(read_to.number, to.number);
+		ck_assert_int_eq(read_to.animation1, to.animation1);
+
+		for (int32_t j = 0; j < 3; j++) {
+			ck_assert_msg(fabs(read_to.origin[j] - to.origin[j]) <= epsilon, "%s != %s",
+			              vtos(read_to.origin), vtos(to.origin));
+		}
+
+		from = to;
+		read_from = read_to;
+	}
+
+	return size;
+}
+
+START_TEST(check_Net_WriteDeltaEntity) {
+
+	const size_t legacy = check_Net_WriteDeltaEntity_protocol(PROTOCOL_MAJOR_LEGACY, 0.0);
+	const size_t current = check_Net_WriteDeltaEntity_protocol(PROTOCOL_MAJOR, 0.5 / 8.0);
+
+	ck_assert(current < legacy);
+
+	Com_Print("Net_WriteDeltaEntity: %d frames in %zu bytes (%d), %zu bytes (%d)\n",
+	          NUM_FRAMES, legacy, PROTOCOL_MAJOR_LEGACY, current, PROTOCOL_MAJOR);
+
+} END_TEST
+
+START_TEST(check_Net_WriteDeltaPlayerState) {
+	player_state_t from, to, read_to;
+
+	memset(&from, 0, sizeof(from));
+	to = from;
+
+	VectorSet(to.pm_state.origin, 1e9, -1024.0625, 3.0); // exceeds the quantized range
+	VectorSet(to.pm_state.velocity, 300.0, 0.0, -800.0);
+	to.stats[0] = 100;
+	to.stats[MAX_STATS - 1] = -1;
+
+	Net_WriteDeltaPlayerState(&message, &from, &to, PROTOCOL_MAJOR);
+
+	Net_BeginReading(&message);
+	Net_ReadDeltaPlayerState(&message, &from, &read_to, PROTOCOL_MAJOR);
+
+	ck_assert_int_eq(message.read, message.size);
+	ck_assert(VectorCompare(read_to.pm_state.origin, to.pm_state.origin));
+	ck_assert(VectorCompare(read_to.pm_state.velocity, to.pm_state.velocity));
+	ck_assert_int_eq(read_to.stats[0], 100);
+	ck_assert_int_eq(read_to.stats[MAX_STATS - 1], -1);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_net_message");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Net_WriteBits);
+	tcase_add_test(tcase, check_Net_WriteDeltaEntity);
+	tcase_add_test(tcase, check_Net_WriteDeltaPlayerState);
+
+	Suite *suite = suite_create("check_net_message");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
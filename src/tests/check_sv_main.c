@@ -0,0 +1,166 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "sv_local.h"
+
+quetoo_t quetoo;
+
+cvar_t *dedicated;
+cvar_t *game;
+cvar_t *ai;
+cvar_t *time_demo;
+cvar_t *time_scale;
+
+#define NUM_CLIENTS 4
+
+static sv_client_t clients[NUM_CLIENTS];
+
+static cvar_t max_clients;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	memset(&svs, 0, sizeof(svs));
+	memset(clients, 0, sizeof(clients));
+
+	svs.clients = clients;
+	svs.client_addresses = g_hash_table_new(g_int64_hash, g_int64_equal);
+
+	memset(&max_clients, 0, sizeof(max_clients));
+	max_clients.integer = NUM_CLIENTS;
+	sv_max_clients = &max_clients;
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	g_hash_table_destroy(svs.client_addresses);
+
+	Mem_Shutdown();
+}
+
+/**
+ * @brief Connects the client from the specified address and qport.
+ */
+static void connect_client(sv_client_t *cl, const in_addr_t addr, const uint8_t qport) {
+
+	cl->state = SV_CLIENT_CONNECTED;
+
+	cl->net_chan.remote_address.type = NA_DATAGRAM;
+	cl->net_chan.remote_address.addr = addr;
+	cl->net_chan.qport = qport;
+
+	Sv_LinkClientAddress(cl);
+}
+
+/**
+ * @brief Drops the client, as Sv_DropClient does.
+ */
+static void drop_client(sv_client_t *cl) {
+
+	Sv_UnlinkClientAddress(cl);
+
+	memset(cl, 0, sizeof(*cl));
+}
+
+/**
+ * @return The client found by the address table for the specified client's key.
+ */
+static sv_client_t *lookup_client(const sv_client_t *cl) {
+	const gint64 key = cl->address_key;
+
+	return g_hash_table_lookup(svs.client_addresses, &key);
+}
+
+START_TEST(check_Sv_LinkClientAddress) {
+	sv_client_t *lower = &clients[1], *higher = &clients[2];
+
+	// the higher slot connects first, and the lower slot then takes over its key
+	connect_client(higher, 0x0100007f, 1);
+	connect_client(lower, 0x0100007f, 1);
+
+	ck_assert_int_eq(lower->address_key, higher->address_key);
+	ck_assert_ptr_eq(lookup_client(lower), lower);
+
+	const gint64 key = lower->address_key;
+
+	// dropping the higher slot must leave the lower slot reachable by its key
+	drop_client(higher);
+
+	ck_assert_ptr_eq(lookup_client(lower), lower);
+	ck_assert_ptr_eq(g_hash_table_lookup(svs.client_addresses, &(gint64) { 0 }), NULL);
+	ck_assert_int_eq(g_hash_table_size(svs.client_addresses), 1);
+
+	// and dropping the lower slot empties the table
+	drop_client(lower);
+
+	ck_assert_ptr_eq(g_hash_table_lookup(svs.client_addresses, &key), NULL);
+	ck_assert_int_eq(g_hash_table_size(svs.client_addresses), 0);
+
+} END_TEST
+
+START_TEST(check_Sv_UnlinkClientAddress) {
+	sv_client_t *lower = &clients[1], *higher = &clients[2];
+
+	connect_client(lower, 0x0100007f, 1);
+	connect_client(higher, 0x0100007f, 1);
+
+	ck_assert_ptr_eq(lookup_client(higher), lower);
+
+	// dropping the lower slot promotes the higher one
+	drop_client(lower);
+
+	ck_assert_ptr_eq(lookup_client(higher), higher);
+
+	drop_client(higher);
+
+	ck_assert_int_eq(g_hash_table_size(svs.client_addresses), 0);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_sv_main");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Sv_LinkClientAddress);
+	tcase_add_test(tcase, check_Sv_UnlinkClientAddress);
+
+	Suite *suite = suite_create("check_sv_main");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
@@ -0,0 +1,544 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "sv_local.h"
+
+quetoo_t quetoo;
+
+cvar_t *dedicated;
+cvar_t *game;
+cvar_t *ai;
+cvar_t *time_demo;
+cvar_t *time_scale;
+
+#define NUM_ENTITIES 1000
+#define NUM_ITERATIONS 100
+#define NUM_HOT_SPOTS 4
+#define NUM_BENCHMARK_ITERATIONS 10
+
+static g_entity_t entities[MAX_ENTITIES];
+static g_export_t ge;
+
+static cvar_t adaptive_sectors;
+static cvar_t trace_cache;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	Fs_Init(FS_AUTO_LOAD_ARCHIVES);
+
+	memset(&sv, 0, sizeof(sv));
+	memset(&svs, 0, sizeof(svs));
+	memset(entities, 0, sizeof(entities));
+
+	ge.entities = entities;
+	ge.entity_size = sizeof(g_entity_t);
+	ge.num_entities = NUM_ENTITIES + 1;
+
+	svs.game = &ge;
+
+	memset(&adaptive_sectors, 0, sizeof(adaptive_sectors));
+	sv_adaptive_sectors = &adaptive_sectors;
+
+	memset(&trace_cache, 0, sizeof(trace_cache));
+	sv_trace_cache = &trace_cache;
+
+	sv.cm_models[0] = Cm_LoadBspModel("maps/torn.bsp", NULL);
+	sv.state = SV_ACTIVE_GAME;
+
+	Sv_InitWorld();
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	Cm_LoadBspModel(NULL, NULL);
+
+	Fs_Shutdown();
+
+	Mem_Shutdown();
+}
+
+/**
+ * @brief Places the entity at a random position within the world.
+ */
+static void randomize(g_entity_t *ent) {
+	const cm_bsp_model_t *world = sv.cm_models[0];
+
+	for (int32_t i = 0; i < 3; i++) {
+		ent->s.origin[i] = Randomfr(world->mins[i], world->maxs[i]);
+	}
+}
+
+START_TEST(check_Sv_LinkEntity) {
+	const cm_bsp_model_t *world = sv.cm_models[0];
+	g_entity_t *list[MAX_ENTITIES];
+
+	for (int32_t i = 1; i <= NUM_ENTITIES; i++) {
+		g_entity_t *ent = &entities[i];
+
+		ent->in_use = true;
+		ent->solid = SOLID_BOX;
+
+		VectorSet(ent->mins, -16.0, -16.0, -24.0);
+		VectorSet(ent->maxs, 16.0, 16.0, 32.0);
+
+		randomize(ent);
+		Sv_LinkEntity(ent);
+	}
+
+	// every solid entity must be found by a query spanning the world
+	size_t count = Sv_BoxEntities(world->mins, world->maxs, list, lengthof(list), BOX_COLLIDE);
+	ck_assert_int_eq(count, NUM_ENTITIES);
+
+	// relink every entity at a new position, as projectiles and players do
+	gint64 start = g_get_monotonic_time();
+
+	for (int32_t i = 0; i < NUM_ITERATIONS; i++) {
+		for (int32_t j = 1; j <= NUM_ENTITIES; j++) {
+			randomize(&entities[j]);
+			Sv_LinkEntity(&entities[j]);
+		}
+	}
+
+	const gint64 link_time = g_get_monotonic_time() - start;
+
+	// and query the area around each entity, as movement and traces do
+	size_t found = 0;
+	start = g_get_monotonic_time();
+
+	for (int32_t i = 0; i < NUM_ITERATIONS; i++) {
+		for (int32_t j = 1; j <= NUM_ENTITIES; j++) {
+			const g_entity_t *ent = &entities[j];
+			vec3_t mins, maxs;
+
+			for (int32_t k = 0; k < 3; k++) {
+				mins[k] = ent->abs_mins[k] - 64.0;
+				maxs[k] = ent->abs_maxs[k] + 64.0;
+			}
+
+			found += Sv_BoxEntities(mins, maxs, list, lengthof(list), BOX_COLLIDE);
+		}
+	}
+
+	const gint64 box_time = g_get_monotonic_time() - start;
+
+	ck_assert(found >= NUM_ENTITIES * NUM_ITERATIONS);
+
+	const int32_t ops = NUM_ENTITIES * NUM_ITERATIONS;
+
+	Com_Print("Sv_LinkEntity: %d in %" PRId64 "ms (%.0f/s)\n", ops,
+	          (int64_t) (link_time / 1000), ops * 1000000.0 / MAX(link_time, 1));
+	Com_Print("Sv_BoxEntities: %d in %" PRId64 "ms (%.0f/s), %.1f entities per query\n", ops,
+	          (int64_t) (box_time / 1000), ops * 1000000.0 / MAX(box_time, 1), found / (double) ops);
+
+	// freeing entities must remove them from the world
+	for (int32_t i = 1; i <= NUM_ENTITIES; i++) {
+		entities[i].in_use = false;
+		Sv_LinkEntity(&entities[i]);
+	}
+
+	count = Sv_BoxEntities(world->mins, world->maxs, list, lengthof(list), BOX_COLLIDE);
+	ck_assert_int_eq(count, 0);
+
+} END_TEST
+
+/**
+ * @brief Links NUM_ENTITIES entities at the given origins, builds the sector
+ * tree, and queries the area around each entity.
+ *
+ * @return The number of entities found.
+ */
+static size_t benchmark(const char *map, vec3_t *origins, int32_t adaptive) {
+	g_entity_t *list[MAX_ENTITIES];
+
+	adaptive_sectors.integer = adaptive;
+
+	memset(sv.entities, 0, sizeof(sv.entities));
+	Sv_InitWorld();
+
+	for (int32_t i = 1; i <= NUM_ENTITIES; i++) {
+		g_entity_t *ent = &entities[i];
+
+		memset(ent, 0, sizeof(*ent));
+
+		ent->in_use = true;
+		ent->solid = SOLID_BOX;
+
+		VectorSet(ent->mins, -16.0, -16.0, -24.0);
+		VectorSet(ent->maxs, 16.0, 16.0, 32.0);
+
+		VectorCopy(origins[i], ent->s.origin);
+		Sv_LinkEntity(ent);
+	}
+
+	sv.frame_num = 0;
+	Sv_UpdateWorld();
+
+	memset(&sv.world_stats, 0, sizeof(sv.world_stats));
+
+	size_t found = 0;
+	const gint64 start = g_get_monotonic_time();
+
+	for (int32_t i = 0; i < NUM_BENCHMARK_ITERATIONS; i++) {
+		for (int32_t j = 1; j <= NUM_ENTITIES; j++) {
+			const g_entity_t *ent = &entities[j];
+			vec3_t mins, maxs;
+
+			for (int32_t k = 0; k < 3; k++) {
+				mins[k] = ent->abs_mins[k] - 64.0;
+				maxs[k] = ent->abs_maxs[k] + 64.0;
+			}
+
+			found += Sv_BoxEntities(mins, maxs, list, lengthof(list), BOX_COLLIDE);
+		}
+	}
+
+	const gint64 time = g_get_monotonic_time() - start;
+	sv_world_stats_t *stats = &sv.world_stats;
+
+	const double queries = SDL_AtomicGet(&stats->queries);
+
+	Com_Print("%s %s: %" PRId64 "ms, %.1f sectors, %.1f tests, %.1f entities per query\n",
+	          map, adaptive ? "adaptive" : "uniform", (int64_t) (time / 1000),
+	          SDL_AtomicGet(&stats->sectors) / queries,
+	          SDL_AtomicGet(&stats->tests) / queries,
+	          SDL_AtomicGet(&stats->entities) / queries);
+
+	return found;
+}
+
+/**
+ * @brief Fs_Enumerator for check_Sv_BoxEntities. Entities congregate about a
+ * few hot spots, as players and projectiles do, so that uniform sectors are
+ * unevenly populated.
+ */
+static void check_Sv_BoxEntities_enumerate(const char *path, void *data) {
+	vec3_t origins[NUM_ENTITIES + 1], hot_spots[NUM_HOT_SPOTS];
+
+	const cm_bsp_model_t *world = sv.cm_models[0] = Cm_LoadBspModel(path, NULL);
+
+	for (int32_t i = 0; i < NUM_HOT_SPOTS; i++) {
+		for (int32_t j = 0; j < 3; j++) {
+			hot_spots[i][j] = Randomfr(world->mins[j], world->maxs[j]);
+		}
+	}
+
+	for (int32_t i = 1; i <= NUM_ENTITIES; i++) {
+		const vec_t *hot_spot = hot_spots[i % NUM_HOT_SPOTS];
+
+		for (int32_t j = 0; j < 3; j++) {
+			origins[i][j] = Clamp(hot_spot[j] + Randomfr(-512.0, 512.0), world->mins[j], world->maxs[j]);
+		}
+	}
+
+	const size_t uniform = benchmark(path, origins, 0);
+	const size_t adaptive = benchmark(path, origins, 1);
+
+	ck_assert_msg(uniform == adaptive, "%s: %zu uniform, %zu adaptive", path, uniform, adaptive);
+
+	(*(int32_t *) data)++;
+}
+
+START_TEST(check_Sv_BoxEntities) {
+	int32_t maps = 0;
+
+	Fs_Enumerate("maps/*.bsp", check_Sv_BoxEntities_enumerate, &maps);
+
+	ck_assert(maps > 0);
+
+} END_TEST
+
+START_TEST(check_Sv_Trace) {
+
+	for (int32_t i = 1; i <= NUM_ENTITIES; i++) {
+		g_entity_t *ent = &entities[i];
+
+		ent->in_use = true;
+		ent->solid = SOLID_BOX;
+
+		VectorSet(ent->mins, -16.0, -16.0, -24.0);
+		VectorSet(ent->maxs, 16.0, 16.0, 32.0);
+
+		randomize(ent);
+		Sv_LinkEntity(ent);
+	}
+
+	memset(&sv.world_stats, 0, sizeof(sv.world_stats));
+
+	const gint64 start = g_get_monotonic_time();
+
+	for (int32_t i = 0; i < NUM_BENCHMARK_ITERATIONS; i++) {
+		for (int32_t j = 1; j <= NUM_ENTITIES; j++) {
+			const g_entity_t *ent = &entities[j];
+			vec3_t start;
+
+			VectorCopy(ent->s.origin, start);
+			start[0] += 256.0;
+
+			// a trace into an entity is blocked by it, or by something nearer
+			cm_trace_t tr = Sv_Trace(start, ent->s.origin, NULL, NULL, NULL, CONTENTS_SOLID);
+			ck_assert(tr.fraction < 1.0);
+			ck_assert(tr.ent != NULL);
+
+			// unless it is skipped, in which case only the world or others may block it
+			tr = Sv_Trace(start, ent->s.origin, NULL, NULL, ent, CONTENTS_SOLID);
+			ck_assert(tr.ent != ent);
+		}
+	}
+
+	const gint64 time = g_get_monotonic_time() - start;
+	sv_world_stats_t *stats = &sv.world_stats;
+
+	const int32_t traces = SDL_AtomicGet(&stats->traces);
+
+	ck_assert_int_eq(traces, NUM_BENCHMARK_ITERATIONS * NUM_ENTITIES * 2);
+
+	Com_Print("Sv_Trace: %" PRId64 "ms, %.1f candidates, %.1f clipped per trace\n",
+	          (int64_t) (time / 1000),
+	          SDL_AtomicGet(&stats->candidates) / (double) traces,
+	          SDL_AtomicGet(&stats->clips) / (double) traces);
+
+} END_TEST
+
+/**
+ * @brief Links NUM_ENTITIES player-sized boxes at random positions.
+ */
+static void link_boxes(void) {
+
+	for (int32_t i = 1; i <= NUM_ENTITIES; i++) {
+		g_entity_t *ent = &entities[i];
+
+		ent->in_use = true;
+		ent->solid = SOLID_BOX;
+
+		VectorSet(ent->mins, -16.0, -16.0, -24.0);
+		VectorSet(ent->maxs, 16.0, 16.0, 32.0);
+
+		randomize(ent);
+		Sv_LinkEntity(ent);
+	}
+}
+
+/**
+ * @brief Traces into the specified entity from 256 units along the X axis.
+ */
+static cm_trace_t trace_into(const g_entity_t *ent) {
+	vec3_t start;
+
+	VectorCopy(ent->s.origin, start);
+	start[0] += 256.0;
+
+	return Sv_Trace(start, ent->s.origin, ent->mins, ent->maxs, NULL, MASK_CLIP_PLAYER);
+}
+
+START_TEST(check_Sv_Trace_cache) {
+
+	link_boxes();
+
+	sv_trace_cache_stats_t *stats = &sv.trace_cache_stats;
+
+	for (int32_t i = 1; i <= NUM_ENTITIES; i++) {
+		g_entity_t *ent = &entities[i];
+
+		trace_cache.integer = 0;
+
+		const cm_trace_t expected = trace_into(ent);
+		const int32_t expected_contents = Sv_PointContents(ent->s.origin);
+
+		trace_cache.integer = 1;
+
+		// the first query misses, and repeating it hits with the same result
+		const int32_t misses = SDL_AtomicGet(&stats->trace_misses);
+		const int32_t hits = SDL_AtomicGet(&stats->trace_hits);
+
+		for (int32_t j = 0; j < 2; j++) {
+			const cm_trace_t tr = trace_into(ent);
+
+			ck_assert(tr.fraction == expected.fraction);
+			ck_assert(tr.ent == expected.ent);
+			ck_assert_int_eq(Sv_PointContents(ent->s.origin), expected_contents);
+		}
+
+		ck_assert_int_eq(SDL_AtomicGet(&stats->trace_misses), misses + 1);
+		ck_assert_int_eq(SDL_AtomicGet(&stats->trace_hits), hits + 1);
+
+		// relinking any entity invalidates the cache
+		Sv_LinkEntity(&entities[(i % NUM_ENTITIES) + 1]);
+
+		trace_into(ent);
+		ck_assert_int_eq(SDL_AtomicGet(&stats->trace_misses), misses + 2);
+	}
+
+	ck_assert_int_eq(SDL_AtomicGet(&stats->point_contents_hits), NUM_ENTITIES);
+	ck_assert_int_eq(SDL_AtomicGet(&stats->point_contents_misses), NUM_ENTITIES);
+
+} END_TEST
+
+START_TEST(check_Sv_Trace_cache_Sv_LinkEntity) {
+
+	link_boxes();
+
+	trace_cache.integer = 1;
+
+	for (int32_t i = 1; i <= NUM_ENTITIES; i++) {
+		g_entity_t *ent = &entities[i];
+		vec3_t start, end;
+
+		VectorCopy(ent->s.origin, end);
+		VectorCopy(ent->s.origin, start);
+		start[0] += 256.0;
+
+		const cm_trace_t cached = Sv_Trace(start, end, ent->mins, ent->maxs, NULL, MASK_CLIP_PLAYER);
+
+		if (cached.ent != ent) {
+			continue; // blocked by the world or another entity
+		}
+
+		// move the entity well clear of the trace, and the cached result must not survive
+		ent->s.origin[1] += 4096.0;
+		Sv_LinkEntity(ent);
+
+		const cm_trace_t tr = Sv_Trace(start, end, ent->mins, ent->maxs, NULL, MASK_CLIP_PLAYER);
+		ck_assert(tr.ent != ent);
+
+		trace_cache.integer = 0;
+
+		const cm_trace_t expected = Sv_Trace(start, end, ent->mins, ent->maxs, NULL, MASK_CLIP_PLAYER);
+		ck_assert(tr.fraction == expected.fraction);
+		ck_assert(tr.ent == expected.ent);
+
+		trace_cache.integer = 1;
+	}
+
+} END_TEST
+
+static cm_trace_t serial_traces[NUM_ENTITIES + 1], concurrent_traces[NUM_ENTITIES + 1];
+static int32_t serial_contents[NUM_ENTITIES + 1], concurrent_contents[NUM_ENTITIES + 1];
+static size_t serial_boxes[NUM_ENTITIES + 1], concurrent_boxes[NUM_ENTITIES + 1];
+
+/**
+ * @return The number of entities within 64 units of the specified entity.
+ */
+static size_t box_around(const g_entity_t *ent) {
+	g_entity_t *list[MAX_ENTITIES];
+	vec3_t mins, maxs;
+
+	for (int32_t i = 0; i < 3; i++) {
+		mins[i] = ent->abs_mins[i] - 64.0;
+		maxs[i] = ent->abs_maxs[i] + 64.0;
+	}
+
+	return Sv_BoxEntities(mins, maxs, list, lengthof(list), BOX_COLLIDE);
+}
+
+/**
+ * @brief ThreadRangeFunc for check_Sv_Trace_cache_threads. Each trace is issued
+ * twice, so that the second is answered by the calling thread's cache.
+ */
+static void trace_range(size_t start, size_t end, void *data) {
+
+	for (size_t i = start; i < end; i++) {
+		const g_entity_t *ent = &entities[i + 1];
+
+		trace_into(ent);
+		concurrent_traces[i + 1] = trace_into(ent);
+		concurrent_contents[i + 1] = Sv_PointContents(ent->s.origin);
+		concurrent_boxes[i + 1] = box_around(ent);
+	}
+}
+
+START_TEST(check_Sv_Trace_cache_threads) {
+
+	Thread_Init(4);
+
+	link_boxes();
+
+	trace_cache.integer = 0;
+
+	for (int32_t i = 1; i <= NUM_ENTITIES; i++) {
+		serial_traces[i] = trace_into(&entities[i]);
+		serial_contents[i] = Sv_PointContents(entities[i].s.origin);
+		serial_boxes[i] = box_around(&entities[i]);
+	}
+
+	trace_cache.integer = 1;
+
+	memset(&sv.world_stats, 0, sizeof(sv.world_stats));
+
+	for (int32_t i = 0; i < NUM_ITERATIONS; i++) {
+
+		memset(concurrent_traces, 0, sizeof(concurrent_traces));
+		memset(concurrent_contents, 0, sizeof(concurrent_contents));
+		memset(concurrent_boxes, 0, sizeof(concurrent_boxes));
+
+		Thread_ParallelFor(NUM_ENTITIES, 16, trace_range, NULL);
+
+		for (int32_t j = 1; j <= NUM_ENTITIES; j++) {
+			ck_assert(concurrent_traces[j].fraction == serial_traces[j].fraction);
+			ck_assert(concurrent_traces[j].ent == serial_traces[j].ent);
+			ck_assert(VectorCompare(concurrent_traces[j].end, serial_traces[j].end));
+			ck_assert_int_eq(concurrent_contents[j], serial_contents[j]);
+			ck_assert_uint_eq(concurrent_boxes[j], serial_boxes[j]);
+		}
+	}
+
+	ck_assert(SDL_AtomicGet(&sv.trace_cache_stats.trace_hits) > 0);
+
+	// no trace is lost from the counters, whichever thread issued it
+	ck_assert_int_eq(SDL_AtomicGet(&sv.world_stats.traces), NUM_ITERATIONS * NUM_ENTITIES * 2);
+
+	Thread_Shutdown();
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_sv_world");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Sv_LinkEntity);
+	tcase_add_test(tcase, check_Sv_BoxEntities);
+	tcase_add_test(tcase, check_Sv_Trace);
+	tcase_add_test(tcase, check_Sv_Trace_cache);
+	tcase_add_test(tcase, check_Sv_Trace_cache_Sv_LinkEntity);
+	tcase_add_test(tcase, check_Sv_Trace_cache_threads);
+
+	Suite *suite = suite_create("check_sv_world");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
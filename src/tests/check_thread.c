@@ -82,6 +82,69 @@ START_TEST(check_Thread_Wait) {
 
 } END_TEST
 
+#define NUM_INDICES 100000
+
+/**
+ * @brief ThreadRangeFunc for check_Thread_ParallelFor.
+ */
+static void visit(size_t start, size_t end, void *data) {
+	volatile gint *visits = data;
+
+	for (size_t i = start; i < end; i++) {
+		g_atomic_int_inc(&visits[i]);
+	}
+}
+
+START_TEST(check_Thread_ParallelFor) {
+	static volatile gint visits[NUM_INDICES];
+
+	memset((void *) visits, 0, sizeof(visits));
+
+	Thread_ParallelFor(NUM_INDICES, 1000, visit, (void *) visits);
+
+	for (size_t i = 0; i < NUM_INDICES; i++) {
+		ck_assert_int_eq(visits[i], 1);
+	}
+
+} END_TEST
+
+/**
+ * @brief ThreadRunFunc for check_Thread_WaitCounter. Each job submits, and
+ * waits for, jobs of its own until the depth is exhausted.
+ */
+static void nest(void *data) {
+	static volatile gint jobs;
+
+	const intptr_t depth = (intptr_t) data;
+
+	g_atomic_int_inc(&jobs);
+
+	if (depth) {
+		thread_counter_t counter = { 0 };
+
+		for (int32_t i = 0; i < 4; i++) {
+			Thread_Submit(nest, (void *) (depth - 1), &counter);
+		}
+
+		Thread_WaitCounter(&counter);
+	} else {
+		ck_assert(g_atomic_int_get(&jobs) > 0);
+	}
+}
+
+START_TEST(check_Thread_WaitCounter) {
+	thread_counter_t counter = { 0 };
+
+	for (int32_t i = 0; i < 4; i++) {
+		Thread_Submit(nest, (void *) 4, &counter);
+	}
+
+	Thread_WaitCounter(&counter);
+
+	ck_assert_int_eq(counter.pending, 0);
+
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -93,6 +156,8 @@ int32_t main(int32_t argc, char **argv) {
 	tcase_add_checked_fixture(tcase, setup, teardown);
 
 	tcase_add_test(tcase, check_Thread_Wait);
+	tcase_add_test(tcase, check_Thread_ParallelFor);
+	tcase_add_test(tcase, check_Thread_WaitCounter);
 
 	Suite *suite = suite_create("check_threads");
 	suite_add_tcase(suite, tcase);
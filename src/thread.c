@@ -20,175 +20,379 @@
  */
 
 #include <SDL_cpuinfo.h>
-#include <SDL_timer.h>
 
 #include "thread.h"
 
+/**
+ * @brief The capacity of each job deque. Jobs submitted to a full deque are
+ * run immediately by the submitting thread.
+ */
+#define THREAD_DEQUE_SIZE 1024
+
+/**
+ * @brief A job, or a range of a parallel-for.
+ */
+typedef struct {
+	ThreadRunFunc run;
+	ThreadRangeFunc run_range;
+	void *data;
+	size_t start, end;
+	thread_counter_t *counter;
+} thread_job_t;
+
+/**
+ * @brief A double-ended queue of jobs. The owning thread pushes and pops jobs
+ * at the bottom, while idle threads steal the oldest jobs from the top.
+ */
+typedef struct {
+	thread_job_t jobs[THREAD_DEQUE_SIZE];
+	uint32_t top, bottom;
+	SDL_SpinLock lock;
+} thread_deque_t;
+
+/**
+ * @brief A worker thread and its deque.
+ */
+typedef struct {
+	SDL_Thread *thread;
+	thread_deque_t deque;
+} thread_worker_t;
+
 typedef struct thread_pool_s {
+	thread_worker_t *workers;
+	size_t num_workers;
+
+	thread_deque_t deque; // jobs submitted by threads outside of the pool
+
 	SDL_mutex *mutex;
+	SDL_cond *cond; // signaled when jobs are submitted or counters complete
 
-	thread_t *threads;
-	size_t num_threads;
+	volatile gint queued; // the number of jobs in all deques
+	volatile gint pushes; // incremented as jobs are submitted
+	volatile gint sleeping; // the number of threads waiting on cond
+	volatile gint running;
 } thread_pool_t;
 
 static thread_pool_t thread_pool;
 
+/**
+ * @brief The worker that the calling thread is, if any.
+ */
+static __thread thread_worker_t *thread_worker;
+
 cvar_t *threads;
 
 /**
- * @brief Wrap the user's function in our own for introspection.
+ * @brief Pushes the job onto the bottom of the deque.
+ *
+ * @return True if the job was pushed, false if the deque is full.
  */
-static int32_t Thread_Run(void *data) {
-	thread_t *t = (thread_t *) data;
+static _Bool Thread_PushJob(thread_deque_t *deque, const thread_job_t *job) {
+	_Bool pushed = false;
 
-	while (thread_pool.mutex) {
+	SDL_AtomicLock(&deque->lock);
 
-		SDL_mutexP(t->mutex);
+	if (deque->bottom - deque->top < THREAD_DEQUE_SIZE) {
+		deque->jobs[deque->bottom++ % THREAD_DEQUE_SIZE] = *job;
+		pushed = true;
+	}
 
-		if (t->status == THREAD_RUNNING) {
-			t->Run(t->data);
+	SDL_AtomicUnlock(&deque->lock);
 
-			t->Run = NULL;
-			t->data = NULL;
+	return pushed;
+}
 
-			t->status = THREAD_WAIT;
-		} else {
-			SDL_CondWait(t->cond, t->mutex);
+/**
+ * @brief Pops the newest job from the bottom of the deque.
+ */
+static _Bool Thread_PopJob(thread_deque_t *deque, thread_job_t *job) {
+	_Bool popped = false;
+
+	SDL_AtomicLock(&deque->lock);
+
+	if (deque->bottom != deque->top) {
+		*job = deque->jobs[--deque->bottom % THREAD_DEQUE_SIZE];
+		popped = true;
+	}
+
+	SDL_AtomicUnlock(&deque->lock);
+
+	return popped;
+}
+
+/**
+ * @brief Steals the oldest job from the top of the deque.
+ *
+ * @param counter If not NULL, only a job submitted with this counter is stolen.
+ */
+static _Bool Thread_StealJob(thread_deque_t *deque, thread_job_t *job, const thread_counter_t *counter) {
+	_Bool stolen = false;
+
+	SDL_AtomicLock(&deque->lock);
+
+	if (deque->bottom != deque->top) {
+		const thread_job_t *j = &deque->jobs[deque->top % THREAD_DEQUE_SIZE];
+
+		if (counter == NULL || j->counter == counter) {
+			*job = *j;
+			deque->top++;
+			stolen = true;
 		}
+	}
+
+	SDL_AtomicUnlock(&deque->lock);
+
+	return stolen;
+}
+
+/**
+ * @brief Finds the next job for the calling thread to run. Workers favor their
+ * own deque, and otherwise steal from the submitting threads and each other.
+ *
+ * @param counter If not NULL, only a job submitted with this counter is taken.
+ */
+static _Bool Thread_NextJob(thread_job_t *job, const thread_counter_t *counter) {
+	_Bool found = false;
 
-		SDL_mutexV(t->mutex);
+	if (g_atomic_int_get(&thread_pool.queued) == 0) {
+		return false;
 	}
 
-	return 0;
+	if (thread_worker && counter == NULL) {
+		found = Thread_PopJob(&thread_worker->deque, job);
+	}
+
+	if (!found) {
+		found = Thread_StealJob(&thread_pool.deque, job, counter);
+	}
+
+	if (!found) {
+		const size_t offset = thread_worker ? (size_t) (thread_worker - thread_pool.workers) : 0;
+
+		for (size_t i = 0; i < thread_pool.num_workers && !found; i++) {
+			thread_worker_t *w = &thread_pool.workers[(offset + i) % thread_pool.num_workers];
+			found = Thread_StealJob(&w->deque, job, counter);
+		}
+	}
+
+	if (found) {
+		g_atomic_int_add(&thread_pool.queued, -1);
+	}
+
+	return found;
 }
 
 /**
- * @brief Initializes the threads backing the thread pool.
+ * @brief Wakes all threads waiting on the pool's condition, if any.
  */
-static void Thread_Init_(ssize_t num_threads) {
+static void Thread_Signal(void) {
 
-	if (num_threads == 0) {
-		num_threads = SDL_GetCPUCount();
-	} else if (num_threads == -1) {
-		num_threads = 0;
-	} else if (num_threads > MAX_THREADS) {
-		num_threads = MAX_THREADS;
+	if (g_atomic_int_get(&thread_pool.sleeping)) {
+		SDL_LockMutex(thread_pool.mutex);
+		SDL_CondBroadcast(thread_pool.cond);
+		SDL_UnlockMutex(thread_pool.mutex);
+	}
+}
+
+/**
+ * @brief Runs the job and updates its counter.
+ */
+static void Thread_RunJob(const thread_job_t *job) {
+
+	if (job->run_range) {
+		job->run_range(job->start, job->end, job->data);
+	} else {
+		job->run(job->data);
+	}
+
+	if (job->counter) {
+		if (g_atomic_int_dec_and_test(&job->counter->pending)) {
+			Thread_Signal();
+		}
 	}
+}
 
-	thread_pool.num_threads = num_threads;
+/**
+ * @brief Queues the job on the calling thread's deque. If there are no workers,
+ * or if the deque is full, the job is run immediately.
+ */
+static void Thread_QueueJob(const thread_job_t *job) {
 
-	if (thread_pool.num_threads) {
-		thread_pool.threads = Mem_Malloc(sizeof(thread_t) * thread_pool.num_threads);
+	if (job->counter) {
+		g_atomic_int_inc(&job->counter->pending);
+	}
 
-		thread_t *t = thread_pool.threads;
-		uint16_t i = 0;
+	if (thread_pool.num_workers) {
+		thread_deque_t *deque = thread_worker ? &thread_worker->deque : &thread_pool.deque;
 
-		for (i = 0; i < thread_pool.num_threads; i++, t++) {
-			t->cond = SDL_CreateCond();
-			t->mutex = SDL_CreateMutex();
-			t->thread = SDL_CreateThread(Thread_Run, __func__, t);
+		g_atomic_int_inc(&thread_pool.queued);
+
+		if (Thread_PushJob(deque, job)) {
+			g_atomic_int_inc(&thread_pool.pushes);
+
+			Thread_Signal();
+			return;
 		}
+
+		g_atomic_int_add(&thread_pool.queued, -1);
 	}
+
+	Thread_RunJob(job);
 }
 
 /**
- * Thread_Shutdown_
+ * @brief Blocks the calling thread until a job is submitted, or until the
+ * counter completes.
  */
-static void Thread_Shutdown_(void) {
+static void Thread_Sleep(const thread_counter_t *counter, const gint pushes) {
 
-	if (thread_pool.num_threads) {
-		thread_t *t = thread_pool.threads;
-		uint16_t i = 0;
+	SDL_LockMutex(thread_pool.mutex);
+	g_atomic_int_inc(&thread_pool.sleeping);
 
-		for (i = 0; i < thread_pool.num_threads; i++, t++) {
-			Thread_Wait(t);
-			SDL_CondSignal(t->cond);
-			SDL_WaitThread(t->thread, NULL);
-			SDL_DestroyCond(t->cond);
-			SDL_DestroyMutex(t->mutex);
+	while (g_atomic_int_get(&thread_pool.running) && g_atomic_int_get(&thread_pool.pushes) == pushes) {
+
+		if (counter && g_atomic_int_get(&counter->pending) == 0) {
+			break;
 		}
 
-		Mem_Free(thread_pool.threads);
+		SDL_CondWait(thread_pool.cond, thread_pool.mutex);
 	}
+
+	g_atomic_int_add(&thread_pool.sleeping, -1);
+	SDL_UnlockMutex(thread_pool.mutex);
 }
 
 /**
- * @brief Creates a new thread to run the specified function. Callers must use
- * Thread_Wait on the returned handle to release the thread when finished.
+ * @brief The worker thread function, which runs jobs until the pool is shut down.
  */
-thread_t *Thread_Create_(const char *name, ThreadRunFunc run, void *data) {
+static int32_t Thread_Run(void *data) {
 
-	thread_t *t = thread_pool.threads;
-	uint16_t i = 0;
+	thread_worker = (thread_worker_t *) data;
 
-	// if threads are available, find an idle one and dispatch it
-	if (thread_pool.num_threads) {
-		SDL_mutexP(thread_pool.mutex);
+	while (g_atomic_int_get(&thread_pool.running)) {
+		thread_job_t job;
 
-		for (i = 0; i < thread_pool.num_threads; i++, t++) {
+		const gint pushes = g_atomic_int_get(&thread_pool.pushes);
 
-			// if the thread appears idle, lock it and check again
-			if (t->status == THREAD_IDLE) {
+		if (Thread_NextJob(&job, NULL)) {
+			Thread_RunJob(&job);
+		} else {
+			Thread_Sleep(NULL, pushes);
+		}
+	}
 
-				SDL_mutexP(t->mutex);
+	return 0;
+}
 
-				// if the thread is idle, dispatch it
-				if (t->status == THREAD_IDLE) {
-					g_strlcpy(t->name, name, sizeof(t->name));
+/**
+ * @brief Submits a job to the thread pool.
+ *
+ * @param run The job function.
+ * @param data The job data.
+ * @param counter An optional counter, which is incremented now and decremented
+ * when the job completes.
+ */
+void Thread_Submit(ThreadRunFunc run, void *data, thread_counter_t *counter) {
 
-					t->Run = run;
-					t->data = data;
+	Thread_QueueJob(&(const thread_job_t) {
+		.run = run,
+		.data = data,
+		.counter = counter
+	});
+}
 
-					t->status = THREAD_RUNNING;
+/**
+ * @brief Waits for all jobs submitted with the counter to complete. While
+ * waiting, the calling thread runs jobs submitted with the counter, and worker
+ * threads run any job. The calling thread sleeps if there is nothing it can do.
+ */
+void Thread_WaitCounter(thread_counter_t *counter) {
 
-					SDL_mutexV(t->mutex);
-					SDL_CondSignal(t->cond);
+	while (g_atomic_int_get(&counter->pending)) {
+		thread_job_t job;
 
-					break;
-				}
+		const gint pushes = g_atomic_int_get(&thread_pool.pushes);
 
-				SDL_mutexV(t->mutex);
-			}
+		if (Thread_NextJob(&job, thread_worker ? NULL : counter)) {
+			Thread_RunJob(&job);
+		} else {
+			Thread_Sleep(counter, pushes);
 		}
-
-		SDL_mutexV(thread_pool.mutex);
 	}
+}
 
-	// if we failed to allocate a thread, run the function in this thread
-	if (i == thread_pool.num_threads) {
-#if 0
-		if (thread_pool.num_threads) {
-			printf("No threads available for %s\n", name);
+/**
+ * @brief Runs the function over the range [0, count), divided into jobs of
+ * `grain` indices, and waits for them to complete. The calling thread runs
+ * the first range itself.
+ */
+void Thread_ParallelFor(size_t count, size_t grain, ThreadRangeFunc run, void *data) {
+
+	grain = MAX(grain, 1);
+
+	if (thread_pool.num_workers == 0 || count <= grain) {
+		if (count) {
+			run(0, count, data);
 		}
-#endif
-		t = NULL;
+		return;
+	}
+
+	thread_counter_t counter = { 0 };
+
+	for (size_t start = grain; start < count; start += grain) {
+		Thread_QueueJob(&(const thread_job_t) {
+			.run_range = run,
+			.data = data,
+			.start = start,
+			.end = MIN(start + grain, count),
+			.counter = &counter
+		});
+	}
+
+	run(0, grain, data);
+
+	Thread_WaitCounter(&counter);
+}
+
+/**
+ * @brief Creates a job to run the specified function. Callers must use
+ * Thread_Wait on the returned handle to release it when finished. If there
+ * are no workers, the function is run immediately, and NULL is returned.
+ */
+thread_t *Thread_Create_(const char *name, ThreadRunFunc run, void *data) {
+
+	if (thread_pool.num_workers == 0) {
 		run(data);
+		return NULL;
 	}
 
+	thread_t *t = Mem_Malloc(sizeof(thread_t));
+	g_strlcpy(t->name, name, sizeof(t->name));
+
+	Thread_Submit(run, data, &t->counter);
+
 	return t;
 }
 
 /**
- * @brief Wait for the specified thread to complete.
+ * @brief Wait for the specified job to complete, and release its handle.
  */
 void Thread_Wait(thread_t *t) {
 
-	if (!t || t->status == THREAD_IDLE) {
+	if (!t) {
 		return;
 	}
 
-	while (t->status != THREAD_WAIT) {
-		SDL_Delay(0);
-	}
+	Thread_WaitCounter(&t->counter);
 
-	t->status = THREAD_IDLE;
+	Mem_Free(t);
 }
 
 /**
  * @brief Returns the number of threads in the pool.
  */
 uint16_t Thread_Count(void) {
-	return thread_pool.num_threads;
+	return thread_pool.num_workers;
 }
 
 /**
@@ -198,22 +402,65 @@ void Thread_Init(ssize_t num_threads) {
 
 	memset(&thread_pool, 0, sizeof(thread_pool));
 
+	if (num_threads == 0) {
+		num_threads = SDL_GetCPUCount();
+	} else if (num_threads == -1) {
+		num_threads = 0;
+	} else if (num_threads > MAX_THREADS) {
+		num_threads = MAX_THREADS;
+	}
+
 	thread_pool.mutex = SDL_CreateMutex();
+	thread_pool.cond = SDL_CreateCond();
+
+	thread_pool.running = true;
 
-	Thread_Init_(num_threads);
+	if (num_threads) {
+		thread_pool.workers = Mem_Malloc(sizeof(thread_worker_t) * num_threads);
+		thread_pool.num_workers = num_threads;
+
+		thread_worker_t *w = thread_pool.workers;
+		for (ssize_t i = 0; i < num_threads; i++, w++) {
+			w->thread = SDL_CreateThread(Thread_Run, __func__, w);
+		}
+	}
 }
 
 /**
- * @brief Shuts down the thread pool.
+ * @brief Shuts down the thread pool, first running any jobs that remain.
  */
 void Thread_Shutdown(void) {
+	thread_job_t job;
+
+	if (!thread_pool.mutex) {
+		return;
+	}
+
+	while (Thread_NextJob(&job, NULL)) {
+		Thread_RunJob(&job);
+	}
+
+	g_atomic_int_set(&thread_pool.running, false);
+
+	SDL_LockMutex(thread_pool.mutex);
+	SDL_CondBroadcast(thread_pool.cond);
+	SDL_UnlockMutex(thread_pool.mutex);
+
+	for (size_t i = 0; i < thread_pool.num_workers; i++) {
+		SDL_WaitThread(thread_pool.workers[i].thread, NULL);
+	}
+
+	// jobs submitted by the jobs we just waited on
+	while (Thread_NextJob(&job, NULL)) {
+		Thread_RunJob(&job);
+	}
 
-	if (thread_pool.mutex) {
-		SDL_DestroyMutex(thread_pool.mutex);
-		thread_pool.mutex = NULL;
+	if (thread_pool.workers) {
+		Mem_Free(thread_pool.workers);
 	}
 
-	Thread_Shutdown_();
+	SDL_DestroyCond(thread_pool.cond);
+	SDL_DestroyMutex(thread_pool.mutex);
 
 	memset(&thread_pool, 0, sizeof(thread_pool));
 }
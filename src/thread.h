@@ -27,27 +27,20 @@
 
 #define MAX_THREADS 128
 
-typedef enum {
-	THREAD_IDLE,
-	THREAD_RUNNING,
-	THREAD_WAIT
-} thread_status_t;
-
-typedef void (*ThreadRunFunc)(void *data);
-
+/**
+ * @brief A handle to a single job, for callers of Thread_Create.
+ */
 typedef struct {
-	SDL_Thread *thread;
-	SDL_cond *cond;
-	SDL_mutex *mutex;
 	char name[64];
-	volatile thread_status_t status;
-	ThreadRunFunc Run;
-	void *data;
+	thread_counter_t counter;
 } thread_t;
 
 thread_t *Thread_Create_(const char *name, ThreadRunFunc run, void *data);
 #define Thread_Create(function, data) Thread_Create_(#function, function, data)
 void Thread_Wait(thread_t *t);
+void Thread_Submit(ThreadRunFunc run, void *data, thread_counter_t *counter);
+void Thread_ParallelFor(size_t count, size_t grain, ThreadRangeFunc run, void *data);
+void Thread_WaitCounter(thread_counter_t *counter);
 uint16_t Thread_Count(void);
 void Thread_Init(ssize_t num_threads);
 void Thread_Shutdown(void);
@@ -492,7 +492,7 @@ static _Bool CheckPlaneAgainstVolume(int32_t pnum, node_t *node) {
  * to partition the brushes with.
  * Returns NULL if there are no valid planes to split with..
  */
-static side_t *SelectSplitSide(brush_t *brushes, node_t *node) {
+static side_t *SelectSplitSide(tree_t *tree, brush_t *brushes, node_t *node) {
 	int32_t value, bestvalue;
 	brush_t *brush, *test;
 	side_t *side, *bestside;
@@ -617,9 +617,7 @@ static side_t *SelectSplitSide(brush_t *brushes, node_t *node) {
 		// if we found a good plane, don't bother trying any other passes
 		if (bestside) {
 			if (pass > 1) {
-				if (debug) {
-					SDL_SemPost(semaphores.nonvis_nodes);
-				}
+				tree->nonvis_nodes++;
 			}
 			if (pass > 0) {
 				node->detail_seperator = true;    // not needed for vis
@@ -732,7 +730,9 @@ void SplitBrush(brush_t *brush, int32_t plane_num, brush_t **front, brush_t **ba
 	}
 
 	if (WindingIsHuge(w)) {
+		ThreadLock();
 		Mon_SendWinding(MON_WARN, (const vec3_t *) w->points, w->num_points, "Large winding");
+		ThreadUnlock();
 	}
 
 	midwinding = w;
@@ -893,18 +893,16 @@ static void SplitBrushList(brush_t *brushes, node_t *node, brush_t **front,
  * BuildTree_r
  * ================
  */
-static node_t *BuildTree_r(node_t *node, brush_t *brushes) {
+static node_t *BuildTree_r(tree_t *tree, node_t *node, brush_t *brushes) {
 	node_t *newnode;
 	side_t *bestside;
 	int32_t i;
 	brush_t *children[2];
 
-	if (debug) {
-		SDL_SemPost(semaphores.vis_nodes);
-	}
+	tree->vis_nodes++;
 
 	// find the best plane to use as a splitter
-	bestside = SelectSplitSide(brushes, node);
+	bestside = SelectSplitSide(tree, brushes, node);
 	if (!bestside) {
 		// leaf node
 		node->side = NULL;
@@ -931,7 +929,7 @@ static node_t *BuildTree_r(node_t *node, brush_t *brushes) {
 
 	// recursively process children
 	for (i = 0; i < 2; i++) {
-		node->children[i] = BuildTree_r(node->children[i], children[i]);
+		node->children[i] = BuildTree_r(tree, node->children[i], children[i]);
 	}
 
 	return node;
@@ -967,7 +965,9 @@ tree_t *BrushBSP(brush_t *brushlist, vec3_t mins, vec3_t maxs) {
 
 		volume = BrushVolume(b);
 		if (volume < microvolume) {
+			ThreadLock();
 			Mon_SendSelect(MON_WARN, b->original->entity_num, b->original->brush_num, "Microbrush");
+			ThreadUnlock();
 		}
 
 		for (i = 0; i < b->num_sides; i++) {
@@ -995,26 +995,17 @@ tree_t *BrushBSP(brush_t *brushlist, vec3_t mins, vec3_t maxs) {
 	Com_Debug(DEBUG_ALL, "%5i visible faces\n", c_faces);
 	Com_Debug(DEBUG_ALL, "%5i nonvisible faces\n", c_nonvisfaces);
 
-	SDL_DestroySemaphore(semaphores.vis_nodes);
-	semaphores.vis_nodes = SDL_CreateSemaphore(0);
-
-	SDL_DestroySemaphore(semaphores.nonvis_nodes);
-	semaphores.nonvis_nodes = SDL_CreateSemaphore(0);
-
 	node = AllocNode();
 
 	node->volume = BrushFromBounds(mins, maxs);
 
 	tree->head_node = node;
 
-	node = BuildTree_r(node, brushlist);
-
-	const uint32_t vis_nodes = SDL_SemValue(semaphores.vis_nodes);
-	const uint32_t nonvis_nodes = SDL_SemValue(semaphores.nonvis_nodes);
+	node = BuildTree_r(tree, node, brushlist);
 
-	Com_Debug(DEBUG_ALL, "%5i visible nodes\n", vis_nodes / 2 - nonvis_nodes);
-	Com_Debug(DEBUG_ALL, "%5i nonvis nodes\n", nonvis_nodes);
-	Com_Debug(DEBUG_ALL, "%5i leafs\n", (vis_nodes + 1) / 2);
+	Com_Debug(DEBUG_ALL, "%5i visible nodes\n", tree->vis_nodes / 2 - tree->nonvis_nodes);
+	Com_Debug(DEBUG_ALL, "%5i nonvis nodes\n", tree->nonvis_nodes);
+	Com_Debug(DEBUG_ALL, "%5i leafs\n", (tree->vis_nodes + 1) / 2);
 
 	return tree;
 }
@@ -116,9 +116,6 @@ static _Bool BrushesDisjoint(const brush_t *a, const brush_t *b) {
 	return false; // might intersect
 }
 
-static int32_t minplane_nums[3];
-static int32_t maxplane_nums[3];
-
 /*
  * ===============
  * ClipBrushToBox
@@ -126,8 +123,8 @@ static int32_t maxplane_nums[3];
  * Any planes shared with the box edge will be set to no texinfo
  * ===============
  */
-static brush_t *ClipBrushToBox(brush_t *brush, vec3_t clipmins,
-                               vec3_t clipmaxs) {
+static brush_t *ClipBrushToBox(brush_t *brush, vec3_t clipmins, vec3_t clipmaxs,
+                               const int32_t *minplane_nums, const int32_t *maxplane_nums) {
 	int32_t i, j;
 	brush_t *front, *back;
 	int32_t p;
@@ -183,6 +180,7 @@ brush_t *MakeBspBrushList(int32_t startbrush, int32_t endbrush, vec3_t clipmins,
 	int32_t c_brushes;
 	int32_t num_sides;
 	int32_t vis;
+	int32_t minplane_nums[2], maxplane_nums[2];
 	vec3_t normal;
 	vec_t dist;
 
@@ -247,7 +245,7 @@ brush_t *MakeBspBrushList(int32_t startbrush, int32_t endbrush, vec3_t clipmins,
 		//
 		// carve off anything outside the clip box
 		//
-		newbrush = ClipBrushToBox(newbrush, clipmins, clipmaxs);
+		newbrush = ClipBrushToBox(newbrush, clipmins, clipmaxs, minplane_nums, maxplane_nums);
 		if (!newbrush) {
 			continue;
 		}
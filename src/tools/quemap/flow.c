@@ -44,7 +44,13 @@ size_t CountBits(const byte *bits, size_t max) {
 	size_t i, c;
 
 	c = 0;
-	for (i = 0; i < max; i++)
+	for (i = 0; i + 64 <= max; i += 64) {
+		uint64_t word;
+		memcpy(&word, bits + (i >> 3), sizeof(word));
+		c += __builtin_popcountll(word);
+	}
+
+	for (; i < max; i++)
 		if (bits[i >> 3] & (1 << (i & 7))) {
 			c++;
 		}
@@ -118,6 +118,21 @@ void BuildFaceExtents(void) {
 	}
 }
 
+/**
+ * @brief ThreadCostFunc for lighting passes. The cost of lighting a face is
+ * proportional to its lightmap area, which BuildFaceExtents has resolved.
+ */
+vec_t FaceLightingCost(int32_t face_num) {
+
+	const bsp_texinfo_t *tex = &bsp_file.texinfo[bsp_file.faces[face_num].texinfo];
+	if (tex->flags & (SURF_SKY | SURF_WARP)) {
+		return 0.0;
+	}
+
+	const face_extents_t *e = &face_extents[face_num];
+	return (e->st_maxs[0] - e->st_mins[0] + 1.0) * (e->st_maxs[1] - e->st_mins[1] + 1.0);
+}
+
 /**
  * @brief Fills in l->tex_mins[] and l->tex_size[], l->exact_mins[] and l->exact_maxs[]
  */
@@ -230,15 +245,27 @@ static void CalcSamplePoints(const light_info_t *l, vec_t sofs, vec_t tofs, vec_
 	}
 }
 
+/**
+ * @brief Indirect light reflected from one face onto a lightmap sample of another.
+ */
+typedef struct {
+	int32_t face_num; // the impacted face
+	int32_t sample; // the impacted sample
+	vec3_t color; // the light to add
+} photon_t;
+
 /**
  * @brief Light sample accumulation for each face.
  */
 typedef struct {
 	int32_t num_samples;
+	int32_t tex_mins[2], tex_size[2]; // the lightmap sample grid
 	vec_t *origins;
 	vec_t *direct;
 	vec_t *directions;
 	vec_t *indirect;
+	photon_t *photons; // reflected by this face, pending MergeIndirectLighting
+	int32_t num_photons;
 } face_lighting_t;
 
 static face_lighting_t face_lighting[MAX_BSP_FACES];
@@ -253,11 +280,50 @@ typedef struct light_s { // a light source
 	vec3_t color;
 	vec3_t normal; // spotlight direction
 	vec_t stopdot; // spotlight cone
+
+	int32_t cluster; // the cluster containing the light
+	vec_t radius; // the radius of influence
 } light_t;
 
-static light_t *lights[MAX_BSP_LEAFS];
+static light_t *lights[MAX_BSP_LEAFS]; // point and spot lights, by cluster
 static int32_t num_lights;
 
+/**
+ * @brief Face light contributions below this value are discarded. This affords face
+ * lights, whose falloff never reaches zero, a radius of influence.
+ */
+#define LIGHT_FACE_CUTOFF 0.1
+
+/**
+ * @brief The point and spot lights that may reach any sample within a cluster.
+ */
+typedef struct {
+	light_t **lights;
+	int32_t num_lights;
+} light_cluster_t;
+
+static light_cluster_t light_clusters[MAX_BSP_LEAFS];
+
+/**
+ * @brief A bounding volume hierarchy of face lights, so that samples need only evaluate
+ * the face lights within range and in front of them.
+ */
+typedef struct {
+	vec3_t mins, maxs; // the bounds of the light origins
+	vec_t radius; // the greatest radius of influence of the lights
+	int32_t children[2]; // for interior nodes, or -1
+	int32_t first_light, num_lights; // for leaf nodes
+} light_node_t;
+
+#define LIGHT_NODE_LIGHTS 4
+
+static light_t *face_light_list; // face lights, until BuildLightNodes
+static light_t **face_lights;
+static int32_t num_face_lights;
+
+static light_node_t *light_nodes;
+static int32_t num_light_nodes;
+
 // sunlight, borrowed from ufo2map
 typedef struct {
 	vec_t light;
@@ -284,6 +350,204 @@ static entity_t *FindTargetEntity(const char *target) {
 	return NULL;
 }
 
+/**
+ * @return The squared distance from the point to the bounds, or 0 if the point is within.
+ */
+static vec_t DistanceToBoundsSquared(const vec3_t point, const vec3_t mins, const vec3_t maxs) {
+
+	vec_t dist = 0.0;
+
+	for (int32_t i = 0; i < 3; i++) {
+		if (point[i] < mins[i]) {
+			dist += (mins[i] - point[i]) * (mins[i] - point[i]);
+		} else if (point[i] > maxs[i]) {
+			dist += (point[i] - maxs[i]) * (point[i] - maxs[i]);
+		}
+	}
+
+	return dist;
+}
+
+/**
+ * @brief Resolves the point and spot lights that may reach each cluster. A light is
+ * included if its own cluster is in the PVS, and its radius reaches the cluster bounds.
+ * The lights are listed in cluster order, so that they are gathered in a fixed order.
+ */
+static void BuildLightClusters(void) {
+
+	const int32_t num_clusters = bsp_file.vis_data.vis->num_clusters;
+
+	vec3_t *mins = Mem_Malloc(num_clusters * sizeof(vec3_t));
+	vec3_t *maxs = Mem_Malloc(num_clusters * sizeof(vec3_t));
+
+	for (int32_t i = 0; i < num_clusters; i++) {
+		ClearBounds(mins[i], maxs[i]);
+	}
+
+	const bsp_leaf_t *leaf = bsp_file.leafs;
+	for (int32_t i = 0; i < bsp_file.num_leafs; i++, leaf++) {
+
+		if (leaf->cluster < 0 || leaf->cluster >= num_clusters) {
+			continue;
+		}
+
+		for (int32_t j = 0; j < 3; j++) { // leaf bounds are truncated, so pad them
+			mins[leaf->cluster][j] = Min(mins[leaf->cluster][j], leaf->mins[j] - 1.0);
+			maxs[leaf->cluster][j] = Max(maxs[leaf->cluster][j], leaf->maxs[j] + 1.0);
+		}
+	}
+
+	light_t **list = Mem_Malloc(Max(num_lights, 1) * sizeof(light_t *));
+	int32_t total = 0;
+
+	for (int32_t i = 0; i < num_clusters; i++) {
+		byte pvs[(MAX_BSP_LEAFS + 7) / 8];
+
+		Bsp_DecompressVis(&bsp_file, bsp_file.vis_data.raw + bsp_file.vis_data.vis->bit_offsets[i][DVIS_PVS], pvs);
+
+		int32_t count = 0;
+
+		for (int32_t j = 0; j < num_clusters; j++) {
+
+			if (!(pvs[j >> 3] & (1 << (j & 7)))) {
+				continue;
+			}
+
+			for (light_t *l = lights[j]; l; l = l->next) {
+				if (DistanceToBoundsSquared(l->origin, mins[i], maxs[i]) < l->radius * l->radius) {
+					list[count++] = l;
+				}
+			}
+		}
+
+		light_cluster_t *lc = &light_clusters[i];
+
+		if (count) {
+			lc->lights = Mem_TagMalloc(count * sizeof(light_t *), MEM_TAG_LIGHT);
+			memcpy(lc->lights, list, count * sizeof(light_t *));
+		}
+
+		lc->num_lights = count;
+		total += count;
+	}
+
+	Mem_Free(list);
+	Mem_Free(mins);
+	Mem_Free(maxs);
+
+	Com_Verbose("%5.1f point and spot lights per cluster\n", total / (vec_t) Max(num_clusters, 1));
+}
+
+static int32_t light_node_axis;
+
+/**
+ * @brief qsort comparator for BuildLightNodes_r, ordering face lights along the split axis.
+ */
+static int32_t BuildLightNodes_Compare(const void *a, const void *b) {
+
+	const int32_t ia = *(const int32_t *) a;
+	const int32_t ib = *(const int32_t *) b;
+
+	const vec_t da = face_lights[ia]->origin[light_node_axis];
+	const vec_t db = face_lights[ib]->origin[light_node_axis];
+
+	if (da != db) {
+		return da < db ? -1 : 1;
+	}
+
+	return ia - ib;
+}
+
+/**
+ * @brief Builds the light node for the given range of face lights, splitting it at the
+ * median of its longest axis.
+ * @return The node number.
+ */
+static int32_t BuildLightNodes_r(int32_t *indices, int32_t first, int32_t count) {
+
+	const int32_t node_num = num_light_nodes++;
+	light_node_t *node = &light_nodes[node_num];
+
+	ClearBounds(node->mins, node->maxs);
+	node->radius = 0.0;
+
+	for (int32_t i = first; i < first + count; i++) {
+		const light_t *l = face_lights[indices[i]];
+
+		AddPointToBounds(l->origin, node->mins, node->maxs);
+		node->radius = Max(node->radius, l->radius);
+	}
+
+	node->children[0] = node->children[1] = -1;
+
+	if (count <= LIGHT_NODE_LIGHTS) {
+		node->first_light = first;
+		node->num_lights = count;
+		return node_num;
+	}
+
+	vec3_t size;
+	VectorSubtract(node->maxs, node->mins, size);
+
+	light_node_axis = 0;
+	for (int32_t i = 1; i < 3; i++) {
+		if (size[i] > size[light_node_axis]) {
+			light_node_axis = i;
+		}
+	}
+
+	qsort(indices + first, count, sizeof(int32_t), BuildLightNodes_Compare);
+
+	const int32_t half = count / 2;
+
+	node->first_light = node->num_lights = 0;
+
+	node->children[0] = BuildLightNodes_r(indices, first, half);
+	node->children[1] = BuildLightNodes_r(indices, first + half, count - half);
+
+	return node_num;
+}
+
+/**
+ * @brief Builds the bounding volume hierarchy of face lights.
+ */
+static void BuildLightNodes(void) {
+
+	if (!num_face_lights) {
+		return;
+	}
+
+	face_lights = Mem_TagMalloc(num_face_lights * sizeof(light_t *), MEM_TAG_LIGHT);
+
+	int32_t i = num_face_lights;
+	for (light_t *l = face_light_list; l; l = l->next) {
+		face_lights[--i] = l; // in the order they were created
+	}
+
+	int32_t *indices = Mem_Malloc(num_face_lights * sizeof(int32_t));
+	for (i = 0; i < num_face_lights; i++) {
+		indices[i] = i;
+	}
+
+	light_nodes = Mem_TagMalloc(2 * num_face_lights * sizeof(light_node_t), MEM_TAG_LIGHT);
+	num_light_nodes = 0;
+
+	BuildLightNodes_r(indices, 0, num_face_lights);
+
+	// reorder the lights so that each leaf node references a contiguous range
+	light_t **sorted = Mem_TagMalloc(num_face_lights * sizeof(light_t *), MEM_TAG_LIGHT);
+	for (i = 0; i < num_face_lights; i++) {
+		sorted[i] = face_lights[indices[i]];
+	}
+
+	Mem_Free(face_lights);
+	face_lights = sorted;
+
+	Mem_Free(indices);
+
+	Com_Verbose("%5i face lights in %i nodes\n", num_face_lights, num_light_nodes);
+}
+
 #define ANGLE_UP	-1.0
 #define ANGLE_DOWN	-2.0
 
@@ -303,30 +567,35 @@ void BuildLights(void) {
 
 	// surfaces
 	for (i = 0; i < lengthof(face_patches); i++) {
-		
-		const patch_t *p = face_patches[i];
-		while (p) { // iterate patches
+		for (const patch_t *p = face_patches[i]; p; p = p->next) {
 
 			if (VectorCompare(p->light, vec3_origin)) {
 				continue;
 			}
 
+			leaf = &bsp_file.leafs[Light_PointLeafnum(p->origin)];
+			cluster = leaf->cluster;
+
+			if (cluster == -1) { // in solid, so it can not be seen
+				continue;
+			}
+
 			num_lights++;
 			l = Mem_TagMalloc(sizeof(*l), MEM_TAG_LIGHT);
 
 			VectorCopy(p->origin, l->origin);
 
-			leaf = &bsp_file.leafs[Light_PointLeafnum(l->origin)];
-			cluster = leaf->cluster;
-			l->next = lights[cluster];
-			lights[cluster] = l;
+			l->cluster = cluster;
+			l->next = face_light_list;
+			face_light_list = l;
+			num_face_lights++;
 
 			l->type = LIGHT_FACE;
 
 			l->intensity = ColorNormalize(p->light, l->color);
 			l->intensity *= p->area * surface_scale;
 
-			p = p->next;
+			l->radius = sqrt(l->intensity / LIGHT_FACE_CUTOFF);
 		}
 	}
 
@@ -339,14 +608,23 @@ void BuildLights(void) {
 			continue;
 		}
 
+		vec3_t origin;
+		VectorForKey(e, "origin", origin);
+
+		leaf = &bsp_file.leafs[Light_PointLeafnum(origin)];
+		cluster = leaf->cluster;
+
+		if (cluster == -1) {
+			Mon_SendSelect(MON_WARN, i, 0, va("Light at %s in solid", vtos(origin)));
+			continue;
+		}
+
 		num_lights++;
 		l = Mem_TagMalloc(sizeof(*l), MEM_TAG_LIGHT);
 
-		VectorForKey(e, "origin", l->origin);
-
-		leaf = &bsp_file.leafs[Light_PointLeafnum(l->origin)];
-		cluster = leaf->cluster;
+		VectorCopy(origin, l->origin);
 
+		l->cluster = cluster;
 		l->next = lights[cluster];
 		lights[cluster] = l;
 
@@ -369,6 +647,8 @@ void BuildLights(void) {
 		l->intensity = intensity * entity_scale;
 		l->type = LIGHT_POINT;
 
+		l->radius = l->intensity; // linear falloff, for spotlights too
+
 		target = ValueForKey(e, "target");
 		if (!g_strcmp0(name, "light_spot") || target[0]) {
 
@@ -412,6 +692,9 @@ void BuildLights(void) {
 
 	Com_Verbose("Lighting %i lights\n", num_lights);
 
+	BuildLightClusters();
+	BuildLightNodes();
+
 	{
 		// sun.light parameters come from worldspawn
 		const entity_t *e = &entities[0];
@@ -470,12 +753,170 @@ void BuildLights(void) {
 	}
 }
 
+/**
+ * @brief A light contribution to a sample, pending its occlusion trace.
+ */
+typedef struct {
+	const light_t *light; // or NULL for sunlight
+	vec_t *sample, *direction; // accumulate lighting and direction here
+	vec3_t normal; // the sample normal
+	vec3_t dir; // the normalized direction to the light
+	vec_t light_value; // the unoccluded light at the sample
+	vec_t scale;
+} light_contribution_t;
+
+/**
+ * @brief Light contributions gathered for a bundle of samples. Their occlusion
+ * traces are run together, ordered by light, so that rays from the same light
+ * to neighboring samples share packets in Light_TraceRays.
+ */
+typedef struct {
+	light_contribution_t *contributions;
+	vec3_t *starts, *ends;
+	size_t count, size;
+} light_bundle_t;
+
+#define LIGHT_BUNDLE_SIZE 1024
+
+/**
+ * @brief Appends a contribution, returning it for the caller to populate.
+ */
+static light_contribution_t *AddLightContribution(light_bundle_t *bundle, const vec3_t start,
+        const vec3_t end) {
+
+	if (bundle->count == bundle->size) {
+		bundle->size = bundle->size ? bundle->size * 2 : LIGHT_BUNDLE_SIZE;
+
+		bundle->contributions = Mem_Realloc(bundle->contributions,
+		                                    bundle->size * sizeof(light_contribution_t));
+		bundle->starts = Mem_Realloc(bundle->starts, bundle->size * sizeof(vec3_t));
+		bundle->ends = Mem_Realloc(bundle->ends, bundle->size * sizeof(vec3_t));
+	}
+
+	VectorCopy(start, bundle->starts[bundle->count]);
+	VectorCopy(end, bundle->ends[bundle->count]);
+
+	return &bundle->contributions[bundle->count++];
+}
+
+/**
+ * @brief Sort key for TraceLightBundle.
+ */
+typedef struct {
+	const light_t *light;
+	uint32_t index;
+} light_order_t;
+
+/**
+ * @brief Orders contributions by light, and then by sample, for coherent tracing.
+ */
+static int32_t TraceLightBundle_Compare(const void *a, const void *b) {
+
+	const light_order_t *oa = (const light_order_t *) a;
+	const light_order_t *ob = (const light_order_t *) b;
+
+	if (oa->light != ob->light) {
+		return oa->light < ob->light ? -1 : 1;
+	}
+
+	return (int32_t) oa->index - (int32_t) ob->index;
+}
+
+/**
+ * @brief Traces the bundled contributions, and accumulates those that are not
+ * occluded. Contributions are accumulated in the order they were gathered, so
+ * that the result does not depend on the trace order.
+ */
+static void TraceLightBundle(light_bundle_t *bundle) {
+
+	const size_t count = bundle->count;
+	if (count == 0) {
+		return;
+	}
+
+	light_order_t *order = Mem_Malloc(count * sizeof(light_order_t));
+	vec3_t *starts = Mem_Malloc(count * sizeof(vec3_t));
+	vec3_t *ends = Mem_Malloc(count * sizeof(vec3_t));
+	cm_trace_t *traces = Mem_Malloc(count * sizeof(cm_trace_t));
+	_Bool *occluded = Mem_Malloc(count * sizeof(_Bool));
+
+	for (size_t i = 0; i < count; i++) {
+		order[i].light = bundle->contributions[i].light;
+		order[i].index = (uint32_t) i;
+	}
+
+	qsort(order, count, sizeof(light_order_t), TraceLightBundle_Compare);
+
+	for (size_t i = 0; i < count; i++) {
+		VectorCopy(bundle->starts[order[i].index], starts[i]);
+		VectorCopy(bundle->ends[order[i].index], ends[i]);
+	}
+
+	Light_TraceRays((const vec3_t *) starts, (const vec3_t *) ends, count, CONTENTS_SOLID, traces);
+
+	for (size_t i = 0; i < count; i++) {
+		const cm_trace_t *trace = &traces[i];
+
+		if (order[i].light) {
+			occluded[order[i].index] = trace->fraction < 1.0;
+		} else {
+			occluded[order[i].index] = trace->fraction < 1.0 && !(trace->surface->flags & SURF_SKY);
+		}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		const light_contribution_t *c = &bundle->contributions[i];
+
+		if (occluded[i]) {
+			continue;
+		}
+
+		vec3_t delta;
+
+		if (c->light) {
+			// add some light to it
+			VectorMA(c->sample, c->light_value * c->scale, c->light->color, c->sample);
+
+			// and add some direction
+			VectorMix(c->normal, c->dir, 2.0 * c->light_value / c->light->intensity, delta);
+			VectorMA(c->direction, c->light_value * c->scale, delta, c->direction);
+		} else {
+			// add some light to it
+			VectorMA(c->sample, c->light_value * c->scale, sun.color, c->sample);
+
+			// and accumulate the direction
+			VectorMix(c->normal, sun.dir, c->light_value / sun.light, delta);
+			VectorMA(c->direction, c->light_value * c->scale, delta, c->direction);
+		}
+	}
+
+	Mem_Free(order);
+	Mem_Free(starts);
+	Mem_Free(ends);
+	Mem_Free(traces);
+	Mem_Free(occluded);
+
+	bundle->count = 0;
+}
+
+/**
+ * @brief Frees the bundle's storage.
+ */
+static void FreeLightBundle(light_bundle_t *bundle) {
+
+	Mem_Free(bundle->contributions);
+	Mem_Free(bundle->starts);
+	Mem_Free(bundle->ends);
+
+	memset(bundle, 0, sizeof(*bundle));
+}
+
 /**
  * @brief A follow-up to GatherSampleLight, simply trace along the sun normal, adding
  * sunlight when a sky surface is struck.
  */
-static void GatherSampleSunlight(const vec3_t pos, const vec3_t normal, vec_t *sample,
-                                 vec_t *direction, vec_t scale) {
+static void GatherSampleSunlight(light_bundle_t *bundle, const vec3_t pos, const vec3_t normal,
+                                 vec_t *sample, vec_t *direction, vec_t scale) {
 
 	if (!sun.light) {
 		return;
@@ -490,106 +931,153 @@ static void GatherSampleSunlight(const vec3_t pos, const vec3_t normal, vec_t *s
 	vec3_t delta;
 	VectorMA(pos, MAX_WORLD_DIST, sun.dir, delta);
 
-	cm_trace_t trace;
-	Light_Trace(&trace, pos, delta, CONTENTS_SOLID);
+	light_contribution_t *c = AddLightContribution(bundle, pos, delta);
+
+	c->light = NULL;
+	c->sample = sample;
+	c->direction = direction;
+	VectorCopy(normal, c->normal);
+	VectorCopy(sun.dir, c->dir);
+	c->light_value = sun.light * dot;
+	c->scale = scale;
+}
+
+/**
+ * @brief Evaluates the falloff of the given light at the sample, gathering its contribution
+ * if the sample is within the light's radius of influence and facing it.
+ */
+static void GatherSampleLightSource(light_bundle_t *bundle, const light_t *l, const vec3_t pos,
+                                    const vec3_t normal, vec_t *sample, vec_t *direction,
+                                    vec_t scale) {
+
+	vec3_t delta;
+	VectorSubtract(l->origin, pos, delta);
+
+	const vec_t dist = VectorNormalize(delta);
+
+	if (dist >= l->radius) {
+		return; // out of range
+	}
+
+	const vec_t dot = DotProduct(delta, normal);
+	if (dot <= 0.001) {
+		return; // behind sample surface
+	}
+
+	vec_t light = 0.0;
+
+	switch (l->type) {
+		case LIGHT_POINT: // linear falloff
+			light = (l->intensity - dist) * dot;
+			break;
+
+		case LIGHT_FACE: // exponential falloff
+			light = (l->intensity / (dist * dist)) * dot;
+			break;
 
-	if (trace.fraction < 1.0 && !(trace.surface->flags & SURF_SKY)) {
-		return; // occluded
+		case LIGHT_SPOT: { // linear falloff with cone
+			const vec_t dot2 = -DotProduct(delta, l->normal);
+			if (dot2 > l->stopdot) { // inside the cone
+				light = (l->intensity - dist) * dot;
+			} else { // outside the cone
+				const vec_t decay = 1.0 + l->stopdot - dot2;
+				light = (l->intensity - decay * decay * dist) * dot;
+			}
+		}
+			break;
+		default:
+			Mon_SendPoint(MON_WARN, l->origin, "Light with bad type");
+			break;
 	}
 
-	const vec_t light = sun.light * dot;
+	if (light <= 0.0) { // no light
+		return;
+	}
 
-	// add some light to it
-	VectorMA(sample, light * scale, sun.color, sample);
+	light_contribution_t *c = AddLightContribution(bundle, l->origin, pos);
 
-	// and accumulate the direction
-	VectorMix(normal, sun.dir, light / sun.light, delta);
-	VectorMA(direction, light * scale, delta, direction);
+	c->light = l;
+	c->sample = sample;
+	c->direction = direction;
+	VectorCopy(normal, c->normal);
+	VectorCopy(delta, c->dir);
+	c->light_value = light;
+	c->scale = scale;
 }
 
 /**
- * @brief Iterate over all light sources for the sample position's PVS, accumulating
- * light and directional information to the specified pointers.
+ * @return True if the light node may reach the sample, false otherwise.
  */
-static void GatherSampleLight(vec3_t pos, vec3_t normal, byte *pvs, vec_t *sample, vec_t *direction, vec_t scale) {
-
-	// iterate over lights, which are in buckets by cluster
-	for (int32_t i = 0; i < bsp_file.vis_data.vis->num_clusters; i++) {
+static _Bool LightNodeReachesSample(const light_node_t *node, const vec3_t pos,
+                                    const vec3_t normal) {
 
-		if (!(pvs[i >> 3] & (1 << (i & 7)))) {
-			continue;
-		}
+	if (DistanceToBoundsSquared(pos, node->mins, node->maxs) >= node->radius * node->radius) {
+		return false; // out of range
+	}
 
-		for (light_t *l = lights[i]; l; l = l->next) {
+	vec3_t corner; // the corner furthest in front of the sample surface
+	for (int32_t i = 0; i < 3; i++) {
+		corner[i] = (normal[i] > 0.0 ? node->maxs[i] : node->mins[i]) - pos[i];
+	}
 
-			vec3_t delta;
-			VectorSubtract(l->origin, pos, delta);
+	return DotProduct(corner, normal) > 0.0;
+}
 
-			const vec_t dist = VectorNormalize(delta);
+/**
+ * @brief Iterate over the light sources which may reach the sample position's cluster,
+ * and the face lights in range, gathering light and directional contributions to the
+ * specified pointers. The contributions are accumulated by TraceLightBundle.
+ */
+static void GatherSampleLight(light_bundle_t *bundle, vec3_t pos, vec3_t normal, int32_t cluster,
+                              byte *pvs, vec_t *sample, vec_t *direction, vec_t scale) {
 
-			const vec_t dot = DotProduct(delta, normal);
-			if (dot <= 0.001) {
-				continue;    // behind sample surface
-			}
+	const light_cluster_t *lc = &light_clusters[cluster];
 
-			vec_t light = 0.0;
+	for (int32_t i = 0; i < lc->num_lights; i++) {
+		GatherSampleLightSource(bundle, lc->lights[i], pos, normal, sample, direction, scale);
+	}
 
-			switch (l->type) {
-				case LIGHT_POINT: // linear falloff
-					light = (l->intensity - dist) * dot;
-					break;
+	if (num_light_nodes) {
+		int32_t stack[64], depth = 0;
 
-				case LIGHT_FACE: // exponential falloff
-					light = (l->intensity / (dist * dist)) * dot;
-					break;
+		stack[depth++] = 0;
 
-				case LIGHT_SPOT: { // linear falloff with cone
-					const vec_t dot2 = -DotProduct(delta, l->normal);
-					if (dot2 > l->stopdot) { // inside the cone
-						light = (l->intensity - dist) * dot;
-					} else { // outside the cone
-						const vec_t decay = 1.0 + l->stopdot - dot2;
-						light = (l->intensity - decay * decay * dist) * dot;
-					}
-				}
-					break;
-				default:
-					Mon_SendPoint(MON_WARN, l->origin, "Light with bad type");
-					break;
-			}
+		while (depth) {
+			const light_node_t *node = &light_nodes[stack[--depth]];
 
-			if (light <= 0.0) { // no light
+			if (!LightNodeReachesSample(node, pos, normal)) {
 				continue;
 			}
 
-			cm_trace_t trace;
-			Light_Trace(&trace, l->origin, pos, CONTENTS_SOLID);
-
-			if (trace.fraction < 1.0) {
-				continue; // occluded
-			}
+			if (node->children[0] == -1) {
+				for (int32_t i = 0; i < node->num_lights; i++) {
+					const light_t *l = face_lights[node->first_light + i];
 
-			// add some light to it
-			VectorMA(sample, light * scale, l->color, sample);
+					if (!(pvs[l->cluster >> 3] & (1 << (l->cluster & 7)))) {
+						continue;
+					}
 
-			// and add some direction
-			VectorMix(normal, delta, 2.0 * light / l->intensity, delta);
-			VectorMA(direction, light * scale, delta, direction);
+					GatherSampleLightSource(bundle, l, pos, normal, sample, direction, scale);
+				}
+			} else {
+				stack[depth++] = node->children[1];
+				stack[depth++] = node->children[0];
+			}
 		}
 	}
 
-	GatherSampleSunlight(pos, normal, sample, direction, scale);
+	GatherSampleSunlight(bundle, pos, normal, sample, direction, scale);
 }
 
 #define SAMPLE_NUDGE 0.25
 
 /**
  * @brief Move the incoming sample position towards the surface center and along the
- * surface normal to reduce false-positive traces. Test the PVS at the new
- * position, returning true if the new point is valid, false otherwise.
+ * surface normal to reduce false-positive traces. Resolve the PVS at the new
+ * position, returning its cluster if the new point is valid, -1 otherwise.
  */
-static _Bool NudgeSamplePosition(const vec3_t in, const vec3_t normal, const vec3_t center,
-                                 vec3_t out, byte *pvs) {
+static int32_t NudgeSamplePosition(const vec3_t in, const vec3_t normal, const vec3_t center,
+                                   vec3_t out, byte *pvs) {
 	vec3_t dir;
 
 	VectorCopy(in, out);
@@ -803,6 +1291,11 @@ void DirectLighting(int32_t face_num) {
 	face_lighting_t *fl = &face_lighting[face_num];
 	fl->num_samples = light.num_sample_points;
 
+	for (int32_t i = 0; i < 2; i++) {
+		fl->tex_mins[i] = light.tex_mins[i];
+		fl->tex_size[i] = light.tex_size[i];
+	}
+
 	fl->origins = Mem_TagMalloc(fl->num_samples * sizeof(vec3_t), MEM_TAG_FACE_LIGHTING);
 	memcpy(fl->origins, light.sample_points, fl->num_samples * sizeof(vec3_t));
 
@@ -812,6 +1305,9 @@ void DirectLighting(int32_t face_num) {
 
 	const vec_t *center = face_extents[face_num].center; // center of the face
 
+	light_bundle_t bundle;
+	memset(&bundle, 0, sizeof(bundle));
+
 	for (int32_t i = 0; i < fl->num_samples; i++) { // calculate light for each sample
 
 		vec_t *sample = fl->direct + i * 3; // accumulate lighting here
@@ -832,30 +1328,92 @@ void DirectLighting(int32_t face_num) {
 
 			vec3_t pos;
 
-			if (!NudgeSamplePosition(point, norm, center, pos, pvs)) {
+			const int32_t cluster = NudgeSamplePosition(point, norm, center, pos, pvs);
+			if (cluster == -1) {
 				continue; // not a valid point
 			}
 
 			// query all light sources within range for their contribution
-			GatherSampleLight(pos, norm, pvs, sample, direction, 1.0 / num_samples);
+			GatherSampleLight(&bundle, pos, norm, cluster, pvs, sample, direction, 1.0 / num_samples);
+		}
+
+		// trace the contributions of neighboring samples together
+		if (bundle.count >= LIGHT_BUNDLE_SIZE) {
+			TraceLightBundle(&bundle);
 		}
 	}
 
+	TraceLightBundle(&bundle);
+	FreeLightBundle(&bundle);
+
 	// free the sample points
 	Mem_Free(light.sample_points);
 }
 
 /**
- * @brief Tests surfaces in the impacted leaf, modulating the lighting sample closest to
+ * @brief Finds the lightmap sample of the face nearest to the given point. The point is
+ * projected onto the face's lightmap grid, and the neighboring samples are compared.
+ * @return The sample index, or -1 if no sample is within range.
+ */
+static int32_t NearestLightmapSample(int32_t face_num, const vec3_t point) {
+
+	const face_lighting_t *fl = &face_lighting[face_num];
+
+	if (fl->num_samples == 0) {
+		return -1;
+	}
+
+	const bsp_texinfo_t *tex = &bsp_file.texinfo[bsp_file.faces[face_num].texinfo];
+
+	const int32_t w = fl->tex_size[0] + 1;
+	const int32_t h = fl->tex_size[1] + 1;
+
+	const int32_t step = 1.0 / lightmap_scale;
+
+	vec3_t p;
+	VectorSubtract(point, face_offset[face_num], p);
+
+	int32_t st[2];
+	for (int32_t i = 0; i < 2; i++) {
+		const vec_t u = DotProduct(p, tex->vecs[i]) + tex->vecs[i][3];
+		st[i] = Clamp((int32_t) floorf(u / step - fl->tex_mins[i] + 0.5), 0, fl->tex_size[i]);
+	}
+
+	vec_t best_dist = MAX_WORLD_DIST;
+	int32_t best = -1;
+
+	for (int32_t t = Max(st[1] - 1, 0); t <= Min(st[1] + 1, h - 1); t++) {
+		for (int32_t s = Max(st[0] - 1, 0); s <= Min(st[0] + 1, w - 1); s++) {
+			const int32_t j = t * w + s;
+
+			const vec_t *origin = fl->origins + j * 3;
+
+			vec3_t delta;
+			VectorSubtract(origin, point, delta);
+
+			const vec_t dist = VectorLengthSquared(delta);
+			if (dist < best_dist) {
+				best = j;
+				best_dist = dist;
+			}
+		}
+	}
+
+	return best;
+}
+
+/**
+ * @brief Tests surfaces in the impacted leaf, resolving the lighting sample closest to
  * the impact point.
+ * @return True if a sample was impacted, false otherwise.
  */
-static void IndirectLightingImpact(const cm_trace_t *trace, const vec3_t color) {
+static _Bool IndirectLightingImpact(const cm_trace_t *trace, const vec3_t color, photon_t *photon) {
 
 	const int32_t leaf_num = Light_PointLeafnum(trace->end);
 
 	if (leaf_num == -1) {
 		Com_Debug(DEBUG_ALL, "Invalid leaf @ %s: %s\n", vtos(trace->end), trace->surface->name);
-		return;
+		return false;
 	}
 
 	const bsp_leaf_t *leaf = &bsp_file.leafs[leaf_num];
@@ -877,37 +1435,25 @@ static void IndirectLightingImpact(const cm_trace_t *trace, const vec3_t color)
 			continue;
 		}
 
-		face_lighting_t *lighting = &face_lighting[face - bsp_file.faces];
-
-		vec_t best_dist = MAX_WORLD_DIST;
-		vec_t *sample = NULL;
-
-		for (int32_t j = 0; j < lighting->num_samples; j++) {
-			const vec_t *org = lighting->origins + j * 3;
+		photon->face_num = (int32_t) (ptrdiff_t) (face - bsp_file.faces);
+		photon->sample = NearestLightmapSample(photon->face_num, trace->end);
 
-			vec3_t delta;
-			VectorSubtract(org, trace->end, delta);
-
-			const vec_t dist = VectorLengthSquared(delta);
-			if (dist < best_dist) {
-				sample = lighting->indirect + j * 3;
-				best_dist = dist;
-			}
-		}
-
-		if (sample) {
-			VectorMA(sample, 1.0 - trace->fraction, color, sample);
+		if (photon->sample == -1) {
+			return false;
 		}
 
-		break; // once we've hit a surface, we can skip the rest of the leaf
+		VectorScale(color, 1.0 - trace->fraction, photon->color);
+		return true; // once we've hit a surface, we can skip the rest of the leaf
 	}
+
+	return false;
 }
 
 /**
  * @brief Calculates indirect lighting via photon bouncing.
  * @details Direct lighting results are reflected outwards. Hits on neighboring surfaces are
- * traced to their lightmap sample, much like stain mapping.
- * @remarks TODO: Ensure this is thread safe for impacted faces.
+ * traced to their lightmap sample, much like stain mapping. The photons are recorded on the
+ * reflecting face, and merged by MergeIndirectLighting, so that faces may be lit concurrently.
  */
 void IndirectLighting(int32_t face_num) {
 
@@ -929,36 +1475,82 @@ void IndirectLighting(int32_t face_num) {
 		VectorCopy(plane->normal, normal);
 	}
 
-	const face_lighting_t *source_lighting = &face_lighting[face_num];
+	face_lighting_t *source_lighting = &face_lighting[face_num];
+
+	const int32_t num_samples = source_lighting->num_samples;
+	if (num_samples == 0) {
+		return;
+	}
+
+	vec3_t *colors = Mem_Malloc(num_samples * sizeof(vec3_t));
+	vec3_t *ends = Mem_Malloc(num_samples * sizeof(vec3_t));
+	cm_trace_t *traces = Mem_Malloc(num_samples * sizeof(cm_trace_t));
 
-	for (int32_t i = 0; i < source_lighting->num_samples; i++) {
+	for (int32_t i = 0; i < num_samples; i++) {
 
 		const vec_t *org = source_lighting->origins + i * 3;
 		const vec_t *sample = source_lighting->direct + i * 3;
 		const vec_t *direction = source_lighting->directions + i * 3;
 
-		vec3_t color;
-		VectorCopy(sample, color);
+		VectorCopy(sample, colors[i]);
 
-		const vec_t light = VectorLength(color) * material->hardness;
-		ColorNormalize(color, color);
+		const vec_t light = VectorLength(colors[i]) * material->hardness;
+		ColorNormalize(colors[i], colors[i]);
 
 		vec3_t reflect;
 		Reflect(direction, normal, reflect);
 
-		vec3_t end;
-		VectorMA(org, light, reflect, end);
+		VectorMA(org, light, reflect, ends[i]);
+	}
+
+	// the reflections of neighboring samples are coherent, so trace them together
+	Light_TraceRays((const vec3_t *) source_lighting->origins, (const vec3_t *) ends, num_samples,
+	                CONTENTS_SOLID, traces);
 
-		cm_trace_t trace;
-		Light_Trace(&trace, org, end, CONTENTS_SOLID);
+	source_lighting->photons = Mem_TagMalloc(num_samples * sizeof(photon_t), MEM_TAG_FACE_LIGHTING);
+	source_lighting->num_photons = 0;
 
-		if (trace.all_solid || trace.fraction == 1.0) {
+	for (int32_t i = 0; i < num_samples; i++) {
+		const cm_trace_t *trace = &traces[i];
+
+		if (trace->all_solid || trace->fraction == 1.0) {
 			continue;
 		}
 
-		assert(trace.surface);
+		assert(trace->surface);
+
+		photon_t *photon = &source_lighting->photons[source_lighting->num_photons];
+
+		if (IndirectLightingImpact(trace, colors[i], photon)) {
+			source_lighting->num_photons++;
+		}
+	}
+
+	Mem_Free(colors);
+	Mem_Free(ends);
+	Mem_Free(traces);
+}
+
+/**
+ * @brief Accumulates the photons of all faces to their impacted samples. Faces are merged
+ * in order, so that the result is the same regardless of how IndirectLighting was threaded.
+ */
+void MergeIndirectLighting(void) {
+
+	for (int32_t i = 0; i < bsp_file.num_faces; i++) {
+		face_lighting_t *fl = &face_lighting[i];
+
+		for (int32_t j = 0; j < fl->num_photons; j++) {
+			const photon_t *photon = &fl->photons[j];
+
+			vec_t *sample = face_lighting[photon->face_num].indirect + photon->sample * 3;
+			VectorAdd(sample, photon->color, sample);
+		}
+
+		Mem_Free(fl->photons);
 
-		IndirectLightingImpact(&trace, color);
+		fl->photons = NULL;
+		fl->num_photons = 0;
 	}
 }
 
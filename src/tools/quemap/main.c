@@ -75,12 +75,19 @@ static void Error(err_t err, const char *msg) {
 	exit(err);
 }
 
+static __thread GPtrArray *print_buffer; // output held back by BeginBufferedOutput
+
 /**
  * @brief Print to stdout and, if not escaped, to the monitor socket.
  */
 static void Print(const char *msg) {
 
 	if (msg) {
+		if (print_buffer) {
+			g_ptr_array_add(print_buffer, g_strdup(msg));
+			return;
+		}
+
 		if (*msg == '@') {
 			fputs(msg + 1, stdout);
 		} else {
@@ -105,6 +112,42 @@ static void Verbose(const char *msg) {
 	Print(msg);
 }
 
+/**
+ * @brief Holds back the calling thread's output, so that work run concurrently
+ * may print in a stable order once it is done.
+ */
+void BeginBufferedOutput(void) {
+
+	assert(!print_buffer);
+
+	print_buffer = g_ptr_array_new_with_free_func(g_free);
+}
+
+/**
+ * @return The calling thread's output since BeginBufferedOutput.
+ */
+GPtrArray *EndBufferedOutput(void) {
+
+	GPtrArray *output = print_buffer;
+	print_buffer = NULL;
+
+	return output;
+}
+
+/**
+ * @brief Prints and frees output returned by EndBufferedOutput.
+ */
+void FlushBufferedOutput(GPtrArray *output) {
+
+	if (output) {
+		for (guint i = 0; i < output->len; i++) {
+			Print(g_ptr_array_index(output, i));
+		}
+
+		g_ptr_array_free(output, true);
+	}
+}
+
 /**
  * @brief Print a warning message to stdout and, if not escaped, to the monitor
  * socket.
@@ -218,6 +261,9 @@ static void Check_BSP_Options(int32_t argc) {
 		} else if (!g_strcmp0(Com_Argv(i), "-leaktest")) {
 			Com_Verbose("leaktest = true\n");
 			leaktest = true;
+		} else if (!g_strcmp0(Com_Argv(i), "-sweep")) {
+			Com_Verbose("sweep = true\n");
+			sweep = true;
 		} else if (!g_strcmp0(Com_Argv(i), "-block")) {
 			block_xl = block_xh = atoi(Com_Argv(i + 1));
 			block_yl = block_yh = atoi(Com_Argv(i + 2));
@@ -347,6 +393,7 @@ static void PrintHelpMessage(void) {
 	Com_Print(" -nowater - skip water brushes\n");
 	Com_Print(" -noweld\n");
 	Com_Print(" -onlyents - modify existing bsp file with entities from map file\n");
+	Com_Print(" -sweep - time the block stage at 1, 2, 4 .. all threads\n");
 	Com_Print(" -tmpout\n");
 	Com_Print("\n");
 
@@ -23,6 +23,8 @@
 #include "qmat.h"
 #include "scriptlib.h"
 
+#include <SDL_atomic.h>
+
 int32_t num_map_brushes;
 map_brush_t map_brushes[MAX_BSP_BRUSHES];
 
@@ -37,6 +39,7 @@ map_plane_t map_planes[MAX_BSP_PLANES];
 
 #define	PLANE_HASHES 4096
 static map_plane_t *plane_hash[PLANE_HASHES];
+static SDL_SpinLock plane_lock; // serializes plane creation
 
 vec3_t map_mins, map_maxs;
 
@@ -95,14 +98,15 @@ static _Bool PlaneEqual(const map_plane_t *p, const vec3_t normal, const dvec_t
 }
 
 /**
- * @brief
+ * @brief Publishes the plane to its hash chain. The plane must be fully
+ * populated, as concurrent FindPlane callers may walk the chain immediately.
  */
 static inline void AddPlaneToHash(map_plane_t *p) {
 
 	const uint16_t hash = ((uint32_t) fabs(p->dist)) & (PLANE_HASHES - 1);
 
 	p->hash_chain = plane_hash[hash];
-	plane_hash[hash] = p;
+	g_atomic_pointer_set(&plane_hash[hash], p);
 }
 
 /**
@@ -188,18 +192,16 @@ static void SnapPlane(vec3_t normal, dvec_t *dist) {
 }
 
 /**
- * @brief
+ * @brief Searches the plane hash, including the border bins, for the given plane.
+ * @return The plane number, or -1 if not found.
  */
-int32_t FindPlane(vec3_t normal, dvec_t dist) {
-	int32_t i;
+static int32_t FindPlane_(const vec3_t normal, const dvec_t dist) {
 
-	SnapPlane(normal, &dist);
 	const uint16_t hash = ((uint32_t) fabsl(dist)) & (PLANE_HASHES - 1);
 
-	// search the border bins as well
-	for (i = -1; i <= 1; i++) {
+	for (int32_t i = -1; i <= 1; i++) {
 		const uint16_t h = (hash + i) & (PLANE_HASHES - 1);
-		const map_plane_t *p = plane_hash[h];
+		const map_plane_t *p = g_atomic_pointer_get(&plane_hash[h]);
 
 		while (p) {
 			if (PlaneEqual(p, normal, dist)) {
@@ -209,7 +211,31 @@ int32_t FindPlane(vec3_t normal, dvec_t dist) {
 		}
 	}
 
-	return CreateNewFloatPlane(normal, dist);
+	return -1;
+}
+
+/**
+ * @brief Finds or creates the given plane. This is safe to call from multiple
+ * threads: lookups are lock-free, and creation is serialized, searching again
+ * for planes created by other threads while we waited.
+ */
+int32_t FindPlane(vec3_t normal, dvec_t dist) {
+
+	SnapPlane(normal, &dist);
+
+	int32_t plane_num = FindPlane_(normal, dist);
+	if (plane_num == -1) {
+		SDL_AtomicLock(&plane_lock);
+
+		plane_num = FindPlane_(normal, dist);
+		if (plane_num == -1) {
+			plane_num = CreateNewFloatPlane(normal, dist);
+		}
+
+		SDL_AtomicUnlock(&plane_lock);
+	}
+
+	return plane_num;
 }
 
 /**
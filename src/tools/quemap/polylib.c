@@ -28,6 +28,92 @@ static uint32_t c_peak_windings;
 
 static const dvec_t MIN_EPSILON = (FLT_EPSILON * (dvec_t) 0.5);
 
+/**
+ * @brief Windings are pooled per thread, in buckets of 4, 8, 16, 32 and 64
+ * points. Freed windings return to the pool of the thread which allocated
+ * them, so that windings built by workers and freed by the main thread are
+ * reused by those workers. The pooled memory is released in bulk by
+ * FreeWindings at the end of each stage. Pools belong to the threads of the
+ * thread pool, which persist until shutdown.
+ */
+#define WINDING_BUCKETS 5
+#define WINDING_CHUNK_SIZE 0x10000
+#define WINDING_STATS_INTERVAL 1024
+
+typedef struct winding_block_s {
+	struct winding_block_s *next; // the next free block in the bucket
+	struct winding_pool_s *pool; // the pool which allocated this block
+	int32_t bucket; // or -1 for windings too large to pool
+	winding_t winding; // variable sized
+} winding_block_t;
+
+typedef struct winding_pool_s {
+	int32_t generation; // the FreeWindings generation this pool was built in
+	winding_block_t *free[WINDING_BUCKETS];
+	winding_block_t *returned[WINDING_BUCKETS]; // freed by other threads, pushed atomically
+	byte *chunk; // the unused remainder of the current chunk
+	size_t chunk_size;
+	winding_stats_t stats; // not yet accumulated to winding_stats
+} winding_pool_t;
+
+static __thread winding_pool_t winding_pool;
+
+static int32_t winding_generation;
+static winding_stats_t winding_stats;
+
+/**
+ * @return The size of a block for the given number of points.
+ */
+static inline size_t WindingBlockSize(int32_t points) {
+	return offsetof(winding_block_t, winding.points) + sizeof(vec3_t) * points;
+}
+
+/**
+ * @brief Accumulates the calling thread's statistics to the shared totals.
+ */
+static void FlushWindingStats(winding_pool_t *pool) {
+
+	g_atomic_int_add(&winding_stats.allocs, pool->stats.allocs);
+	g_atomic_int_add(&winding_stats.reuses, pool->stats.reuses);
+	g_atomic_int_add(&winding_stats.frees, pool->stats.frees);
+	g_atomic_int_add(&winding_stats.returns, pool->stats.returns);
+	g_atomic_int_add(&winding_stats.heap_allocs, pool->stats.heap_allocs);
+
+	memset(&pool->stats, 0, sizeof(pool->stats));
+}
+
+/**
+ * @return The calling thread's pool, reset if its memory has been released.
+ */
+static winding_pool_t *WindingPool(void) {
+
+	winding_pool_t *pool = &winding_pool;
+
+	const int32_t generation = g_atomic_int_get(&winding_generation);
+	if (pool->generation != generation) {
+		memset(pool, 0, sizeof(*pool));
+		pool->generation = generation;
+	}
+
+	return pool;
+}
+
+/**
+ * @brief Takes every block of the given bucket that other threads have returned
+ * to the pool. Only the owning thread takes, so the lock-free stack is safe from
+ * reuse of its head.
+ * @return The first returned block, linked to the rest, or NULL.
+ */
+static winding_block_t *TakeReturnedWindings(winding_pool_t *pool, int32_t bucket) {
+	winding_block_t *head;
+
+	do {
+		head = g_atomic_pointer_get(&pool->returned[bucket]);
+	} while (head && !g_atomic_pointer_compare_and_exchange(&pool->returned[bucket], head, NULL));
+
+	return head;
+}
+
 /**
  * @brief
  */
@@ -42,7 +128,44 @@ winding_t *AllocWinding(int32_t points) {
 		}
 	}
 
-	return Mem_TagMalloc(sizeof(int32_t) + sizeof(vec3_t) * points, MEM_TAG_WINDING);
+	winding_pool_t *pool = WindingPool();
+	winding_block_t *block;
+
+	int32_t bucket = 0;
+	while (bucket < WINDING_BUCKETS && (4 << bucket) < points) {
+		bucket++;
+	}
+
+	if (bucket == WINDING_BUCKETS) {
+		block = Mem_TagMalloc(WindingBlockSize(points), MEM_TAG_WINDING);
+		block->bucket = -1;
+		pool->stats.heap_allocs++;
+	} else if ((block = pool->free[bucket]) || (block = TakeReturnedWindings(pool, bucket))) {
+		pool->free[bucket] = block->next;
+		pool->stats.reuses++;
+	} else {
+		const size_t size = WindingBlockSize(4 << bucket);
+
+		if (pool->chunk_size < size) {
+			pool->chunk = Mem_TagMalloc(WINDING_CHUNK_SIZE, MEM_TAG_WINDING);
+			pool->chunk_size = WINDING_CHUNK_SIZE;
+			pool->stats.heap_allocs++;
+		}
+
+		block = (winding_block_t *) pool->chunk;
+		block->pool = pool;
+		block->bucket = bucket;
+
+		pool->chunk += size;
+		pool->chunk_size -= size;
+	}
+
+	if (++pool->stats.allocs == WINDING_STATS_INTERVAL) {
+		FlushWindingStats(pool);
+	}
+
+	memset(&block->winding, 0, WindingBlockSize(points) - offsetof(winding_block_t, winding));
+	return &block->winding;
 }
 
 /**
@@ -54,7 +177,50 @@ void FreeWinding(winding_t *w) {
 		SDL_SemWait(semaphores.active_windings);
 	}
 
-	Mem_Free(w);
+	winding_block_t *block = (winding_block_t *) ((byte *) w - offsetof(winding_block_t, winding));
+	winding_pool_t *pool = WindingPool();
+
+	if (block->bucket == -1) {
+		Mem_Free(block);
+	} else if (block->pool == pool) {
+		block->next = pool->free[block->bucket];
+		pool->free[block->bucket] = block;
+	} else {
+		winding_block_t **returned = &block->pool->returned[block->bucket];
+		winding_block_t *head;
+
+		do {
+			head = g_atomic_pointer_get(returned);
+			block->next = head;
+		} while (!g_atomic_pointer_compare_and_exchange(returned, head, block));
+
+		pool->stats.returns++;
+	}
+
+	pool->stats.frees++;
+}
+
+/**
+ * @brief Releases all windings, and reports allocator traffic for the stage.
+ * Worker threads accumulate their counters periodically, so the report may
+ * omit their most recent allocations. This must only be called while no other
+ * thread is allocating windings.
+ */
+void FreeWindings(void) {
+
+	FlushWindingStats(WindingPool());
+
+	const winding_stats_t *stats = &winding_stats;
+	if (stats->allocs) {
+		Com_Print("Windings: %d allocated, %d reused, %d freed (%d by other threads), %d heap allocations\n",
+		          stats->allocs, stats->reuses, stats->frees, stats->returns, stats->heap_allocs);
+	}
+
+	memset(&winding_stats, 0, sizeof(winding_stats));
+
+	g_atomic_int_inc(&winding_generation);
+
+	Mem_FreeTag(MEM_TAG_WINDING);
 }
 
 /**
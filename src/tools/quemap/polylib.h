@@ -30,6 +30,14 @@ typedef struct {
 
 #define	MAX_POINTS_ON_WINDING	64
 
+typedef struct {
+	int32_t allocs; // windings allocated
+	int32_t reuses; // allocations satisfied by previously freed windings
+	int32_t frees; // windings freed
+	int32_t returns; // windings freed by a thread other than the one which allocated them
+	int32_t heap_allocs; // allocations from the managed heap
+} winding_stats_t;
+
 #ifndef	ON_EPSILON
 	#define	ON_EPSILON	0.1
 #endif
@@ -46,6 +54,7 @@ winding_t *WindingForFace(const bsp_face_t *f);
 void WindingPlane(const winding_t *w, vec3_t normal, vec_t *dist);
 void RemoveColinearPoints(winding_t *w);
 void FreeWinding(winding_t *w);
+void FreeWindings(void);
 void WindingBounds(const winding_t *w, vec3_t mins, vec3_t maxs);
 void ChopWindingInPlace(winding_t **w, const vec3_t normal, const vec_t dist, const vec_t epsilon);
 // frees the original if clipped
@@ -37,12 +37,14 @@ _Bool noshare = false;
 _Bool notjunc = false;
 _Bool noopt = false;
 _Bool leaktest = false;
+_Bool sweep = false;
 
 int32_t block_xl = -8, block_xh = 7, block_yl = -8, block_yh = 7;
 
 int32_t entity_num;
 
 static node_t *block_nodes[10][10];
+static GPtrArray *block_output[10][10]; // each block's output, printed in order once all are built
 
 /**
  * @brief
@@ -103,6 +105,8 @@ static void ProcessBlock_Thread(int32_t blocknum) {
 	yblock = block_yl + blocknum / (block_xh - block_xl + 1);
 	xblock = block_xl + blocknum % (block_xh - block_xl + 1);
 
+	BeginBufferedOutput();
+
 	Com_Verbose("############### block %2i,%2i ###############\n", xblock, yblock);
 
 	mins[0] = xblock * 1024;
@@ -112,7 +116,7 @@ static void ProcessBlock_Thread(int32_t blocknum) {
 	maxs[1] = (yblock + 1) * 1024;
 	maxs[2] = MAX_WORLD_COORD;
 
-	ThreadLock();
+	// blocks are built concurrently, sharing only the plane table
 
 	// the makelist and chopbrushes could be cached between the passes...
 	brushes = MakeBspBrushList(brush_start, brush_end, mins, maxs);
@@ -121,7 +125,7 @@ static void ProcessBlock_Thread(int32_t blocknum) {
 		node->plane_num = PLANENUM_LEAF;
 		node->contents = CONTENTS_SOLID;
 		block_nodes[xblock + 5][yblock + 5] = node;
-		ThreadUnlock();
+		block_output[xblock + 5][yblock + 5] = EndBufferedOutput();
 		return;
 	}
 
@@ -131,8 +135,75 @@ static void ProcessBlock_Thread(int32_t blocknum) {
 
 	tree = BrushBSP(brushes, mins, maxs);
 
-	ThreadUnlock();
 	block_nodes[xblock + 5][yblock + 5] = tree->head_node;
+	block_output[xblock + 5][yblock + 5] = EndBufferedOutput();
+}
+
+/**
+ * @brief Prints or discards the output of each block, in block order.
+ */
+static void FlushBlockOutput(_Bool print) {
+
+	for (int32_t y = block_yl; y <= block_yh; y++) {
+		for (int32_t x = block_xl; x <= block_xh; x++) {
+			GPtrArray *output = block_output[x + 5][y + 5];
+
+			if (print) {
+				FlushBufferedOutput(output);
+			} else if (output) {
+				g_ptr_array_free(output, true);
+			}
+
+			block_output[x + 5][y + 5] = NULL;
+		}
+	}
+}
+
+/**
+ * @brief Joins the blocks in a tree, only to free them.
+ */
+static void FreeBlocks(void) {
+
+	tree_t *tree = AllocTree();
+	tree->head_node = BlockTree(block_xl - 1, block_yl - 1, block_xh + 1, block_yh + 1);
+
+	FreeTree(tree);
+}
+
+/**
+ * @brief Times the block stage at 1, 2, 4 .. all threads, so that thread counts
+ * may be compared on the map being compiled. A first, untimed pass creates the
+ * planes which the blocks share, so that each timed pass does the same work.
+ */
+static void SweepBlocks(int32_t num_blocks) {
+
+	RunThreadsOn(num_blocks, false, ProcessBlock_Thread);
+
+	FlushBlockOutput(false);
+	FreeBlocks();
+
+	const int32_t max_workers = Max((int32_t) Thread_Count(), 1);
+
+	for (int32_t workers = 1; ; workers = Min(workers * 2, max_workers)) {
+		thread_limit = workers;
+
+		const gint64 start = g_get_monotonic_time();
+
+		RunThreadsOn(num_blocks, false, ProcessBlock_Thread);
+
+		const gint64 elapsed = g_get_monotonic_time() - start;
+
+		FlushBlockOutput(false);
+		FreeBlocks();
+
+		Com_Print("Blocks: %d threads, %d ms\n", workers, (int32_t) (elapsed / 1000));
+
+		if (workers == max_workers) {
+			break;
+		}
+	}
+
+	thread_limit = 0;
 }
 
 /**
@@ -177,11 +248,18 @@ static void ProcessWorldModel(void) {
 		block_yh = 3;
 	}
 
+	const int32_t num_blocks = (block_xh - block_xl + 1) * (block_yh - block_yl + 1);
+
+	if (sweep) {
+		SweepBlocks(num_blocks);
+	}
+
 	for (optimize = 0; optimize <= 1; optimize++) {
 		Com_Verbose("--------------------------------------------\n");
 
-		RunThreadsOn((block_xh - block_xl + 1) * (block_yh - block_yl + 1), !verbose,
-		             ProcessBlock_Thread);
+		RunThreadsOn(num_blocks, !verbose, ProcessBlock_Thread);
+
+		FlushBlockOutput(true);
 
 		// build the division tree
 		// oversizing the blocks guarantees that all the boundaries
@@ -360,6 +438,8 @@ int32_t BSP_Main(void) {
 		ProcessModels();
 	}
 
+	FreeWindings();
+
 	FreeMaterials();
 
 	UnloadScriptFiles();
@@ -141,6 +141,7 @@ typedef struct {
 	node_t *head_node;
 	node_t outside_node;
 	vec3_t mins, maxs;
+	int32_t vis_nodes, nonvis_nodes; // counted by BrushBSP
 } tree_t;
 
 extern int32_t entity_num;
@@ -165,6 +166,7 @@ extern _Bool noshare;
 extern _Bool notjunc;
 extern _Bool noopt;
 extern _Bool leaktest;
+extern _Bool sweep;
 
 extern int32_t block_xl, block_xh, block_yl, block_yh;
 
@@ -66,22 +66,24 @@ int32_t Light_PointLeafnum(const vec3_t point) {
 }
 
 /**
- * @brief
+ * @brief Resolves the PVS for the given point.
+ * @return The cluster containing the point, or -1 if the point is in a solid leaf.
  */
-_Bool Light_PointPVS(const vec3_t org, byte *pvs) {
+int32_t Light_PointPVS(const vec3_t org, byte *pvs) {
+
+	const bsp_leaf_t *leaf = &bsp_file.leafs[Light_PointLeafnum(org)];
 
 	if (!bsp_file.vis_data_size) {
 		memset(pvs, 0xff, (bsp_file.num_leafs + 7) / 8);
-		return true;
+		return leaf->cluster;
 	}
 
-	const bsp_leaf_t *leaf = &bsp_file.leafs[Light_PointLeafnum(org)];
 	if (leaf->cluster == -1) {
-		return false; // in solid leaf
+		return -1; // in solid leaf
 	}
 
 	Bsp_DecompressVis(&bsp_file, bsp_file.vis_data.raw + bsp_file.vis_data.vis->bit_offsets[leaf->cluster][DVIS_PVS], pvs);
-	return true;
+	return leaf->cluster;
 }
 
 /**
@@ -133,6 +135,32 @@ void Light_Trace(cm_trace_t *trace, const vec3_t start, const vec3_t end, int32_
 	}
 }
 
+/**
+ * @brief Traces many rays against all models, as Light_Trace does for one.
+ * Coherent rays, e.g. from one light to neighboring samples, trace fastest.
+ */
+void Light_TraceRays(const vec3_t *starts, const vec3_t *ends, size_t count, int32_t mask,
+                     cm_trace_t *traces) {
+
+	Cm_BoxTraceBatch(starts, ends, vec3_origin, vec3_origin, count, cmodels[0]->head_node, mask, traces);
+
+	if (num_cmodels > 1) {
+		cm_trace_t *tr = Mem_Malloc(count * sizeof(cm_trace_t));
+
+		for (int32_t i = 1; i < num_cmodels; i++) {
+			Cm_BoxTraceBatch(starts, ends, vec3_origin, vec3_origin, count, cmodels[i]->head_node, mask, tr);
+
+			for (size_t j = 0; j < count; j++) {
+				if (tr[j].fraction < traces[j].fraction) {
+					traces[j] = tr[j];
+				}
+			}
+		}
+
+		Mem_Free(tr);
+	}
+}
+
 /**
  * @brief
  */
@@ -171,13 +199,16 @@ static void LightWorld(void) {
 	}
 
 	// calculate direct lighting
-	RunThreadsOn(bsp_file.num_faces, true, DirectLighting);
+	RunThreadsOnCost(bsp_file.num_faces, true, DirectLighting, FaceLightingCost);
 
 	// free the direct light sources
 	Mem_FreeTag(MEM_TAG_LIGHT);
 
 	if (indirect) { // calculate indirect lighting
-		RunThreadsOn(bsp_file.num_faces, true, IndirectLighting);
+		RunThreadsOnCost(bsp_file.num_faces, true, IndirectLighting, FaceLightingCost);
+
+		// and merge the reflected light in face order
+		MergeIndirectLighting();
 	}
 
 	// finalize it and write it out
@@ -185,7 +216,7 @@ static void LightWorld(void) {
 	Bsp_AllocLump(&bsp_file, BSP_LUMP_LIGHTMAPS, MAX_BSP_LIGHTING);
 
 	// merge direct and indirect lighting, normalize all samples
-	RunThreadsOn(bsp_file.num_faces, true, FinalizeLighting);
+	RunThreadsOnCost(bsp_file.num_faces, true, FinalizeLighting, FaceLightingCost);
 
 	// free the face lighting structs
 	Mem_FreeTag(MEM_TAG_FACE_LIGHTING);
@@ -214,6 +245,8 @@ int32_t LIGHT_Main(void) {
 
 	LightWorld();
 
+	FreeWindings();
+
 	FreeTextureColors();
 
 	FreeMaterials();
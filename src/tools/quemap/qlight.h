@@ -53,9 +53,11 @@ extern vec3_t face_offset[MAX_BSP_FACES]; // for rotating bmodels
 // lightmap.c
 void BuildLights(void);
 void BuildFaceExtents(void);
+vec_t FaceLightingCost(int32_t face_num);
 void BuildVertexNormals(void);
 void DirectLighting(int32_t face_num);
 void IndirectLighting(int32_t face_num);
+void MergeIndirectLighting(void);
 void FinalizeLighting(int32_t face_num);
 
 // patches.c
@@ -67,8 +69,10 @@ void SubdividePatches(void);
 void FreePatches(void);
 
 // qlight.c
-_Bool Light_PointPVS(const vec3_t org, byte *pvs);
+int32_t Light_PointPVS(const vec3_t org, byte *pvs);
 _Bool Light_InPVS(const vec3_t point1, const vec3_t point2);
 int32_t Light_PointLeafnum(const vec3_t point);
 void Light_Trace(cm_trace_t *trace, const vec3_t start, const vec3_t end, int32_t mask);
+void Light_TraceRays(const vec3_t *starts, const vec3_t *ends, size_t count, int32_t mask,
+                     cm_trace_t *traces);
 vec3_t *Light_AverageTextureColor(const char *name);
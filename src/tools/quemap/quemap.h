@@ -64,6 +64,7 @@ extern _Bool noshare;
 extern _Bool notjunc;
 extern _Bool noopt;
 extern _Bool leaktest;
+extern _Bool sweep;
 
 extern int32_t block_xl, block_xh, block_yl, block_yh;
 
@@ -88,8 +89,6 @@ extern vec_t patch_size;
 typedef struct semaphores_s {
 	SDL_sem *active_portals;
 	SDL_sem *active_nodes;
-	SDL_sem *vis_nodes;
-	SDL_sem *nonvis_nodes;
 	SDL_sem *active_brushes;
 	SDL_sem *active_windings;
 	SDL_sem *removed_points;
@@ -101,19 +100,31 @@ void Sem_Init(void);
 void Sem_Shutdown(void);
 
 typedef struct thread_work_s {
-	int32_t index; // current work cycle
+	int32_t index; // next work cycle to be claimed
 	int32_t count; // total work cycles
-	int32_t fraction; // last fraction of work completed
+	int32_t completed; // work cycles completed
+	int32_t fraction; // last fraction of work reported
+	int32_t *order; // work cycles, ordered by descending cost, or NULL
+	int32_t workers; // number of threads working
+	int32_t slots; // thread slots claimed
+	int32_t finished; // threads finished working, guarded by the progress mutex
+	gint64 busy[MAX_THREADS]; // time spent working by each thread, in microseconds
 	_Bool progress; // are we reporting progress
 } thread_work_t;
 
 extern thread_work_t thread_work;
+extern int32_t thread_limit;
 
 typedef void (*ThreadWorkFunc)(int32_t);
+typedef vec_t (*ThreadCostFunc)(int32_t);
 
 void ThreadLock(void);
 void ThreadUnlock(void);
+void BeginBufferedOutput(void);
+GPtrArray *EndBufferedOutput(void);
+void FlushBufferedOutput(GPtrArray *output);
 void RunThreadsOn(int32_t workcount, _Bool progress, ThreadWorkFunc func);
+void RunThreadsOnCost(int32_t workcount, _Bool progress, ThreadWorkFunc func, ThreadCostFunc cost);
 
 enum {
 	MEM_TAG_QUEMAP	= 1000,
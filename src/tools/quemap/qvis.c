@@ -375,53 +375,68 @@ static void LoadPortals(const char *filename) {
 }
 
 /**
- * @brief Calculate the PHS (Potentially Hearable Set)
- * by ORing together all the PVS visible from a leaf
+ * @brief Builds the uncompressed PHS (Potentially Hearable Set) row for the given cluster
+ * by ORing together all the PVS visible from it. Rows are padded to 64 bits.
+ */
+static void CalcPHS_Cluster(int32_t cluster) {
+	uint64_t phs[MAX_BSP_LEAFS / 64];
+
+	const size_t num_words = map_vis.leaf_bytes / sizeof(uint64_t);
+	const byte *pvs = map_vis.uncompressed + cluster * map_vis.leaf_bytes;
+
+	memcpy(phs, pvs, map_vis.leaf_bytes);
+
+	for (size_t i = 0; i < num_words; i++) {
+		uint64_t bits;
+
+		memcpy(&bits, pvs + i * sizeof(uint64_t), sizeof(bits));
+		bits = GUINT64_FROM_LE(bits);
+
+		while (bits) {
+			const size_t index = i * 64 + __builtin_ctzll(bits);
+			bits &= bits - 1;
+
+			if (index >= map_vis.portal_clusters) {
+				Com_Error(ERROR_FATAL, "Bad bit vector in PVS\n"); // pad bits should be 0
+			}
+
+			// OR this pvs row into the phs
+			const byte *src = map_vis.uncompressed + index * map_vis.leaf_bytes;
+			for (size_t j = 0; j < num_words; j++) {
+				uint64_t row;
+				memcpy(&row, src + j * sizeof(uint64_t), sizeof(row));
+				phs[j] |= row;
+			}
+		}
+	}
+
+	memcpy(map_vis.uncompressed_phs + cluster * map_vis.leaf_bytes, phs, map_vis.leaf_bytes);
+}
+
+/**
+ * @brief Calculate the PHS of all clusters in parallel, and then compress them in
+ * cluster order, so that the vis lump does not depend on the thread count.
  */
 static void CalcPHS(void) {
-	uint32_t i, j, k, l, index;
-	int32_t bitbyte;
-	byte *dest, *src;
-	byte *scan;
-	int32_t count;
-	byte uncompressed[MAX_BSP_LEAFS / 8];
 	byte compressed[MAX_BSP_LEAFS / 8];
+	size_t count;
 
 	Com_Verbose("Building PHS...\n");
 
+	map_vis.uncompressed_phs = Mem_TagMalloc(map_vis.uncompressed_size, MEM_TAG_PORTAL);
+
+	RunThreadsOn(map_vis.portal_clusters, true, CalcPHS_Cluster);
+
 	count = 0;
-	for (i = 0; i < map_vis.portal_clusters; i++) {
-		scan = map_vis.uncompressed + i * map_vis.leaf_bytes;
-		memcpy(uncompressed, scan, map_vis.leaf_bytes);
-		for (j = 0; j < map_vis.leaf_bytes; j++) {
-			bitbyte = scan[j];
-			if (!bitbyte) {
-				continue;
-			}
-			for (k = 0; k < 8; k++) {
-				if (!(bitbyte & (1 << k))) {
-					continue;
-				}
-				// OR this pvs row into the phs
-				index = ((j << 3) + k);
-				if (index >= map_vis.portal_clusters) {
-					Com_Error(ERROR_FATAL, "Bad bit vector in PVS\n");    // pad bits should be 0
-				}
-				src = (map_vis.uncompressed + index * map_vis.leaf_bytes);
-				for (l = 0; l < map_vis.leaf_bytes; l++) {
-					uncompressed[l] |= src[l];
-				}
-			}
-		}
-		for (j = 0; j < map_vis.portal_clusters; j++)
-			if (uncompressed[j >> 3] & (1 << (j & 7))) {
-				count++;
-			}
+	for (uint32_t i = 0; i < map_vis.portal_clusters; i++) {
+		const byte *uncompressed = map_vis.uncompressed_phs + i * map_vis.leaf_bytes;
+
+		count += CountBits(uncompressed, map_vis.portal_clusters);
 
 		// compress the bit string
-		j = Bsp_CompressVis(&bsp_file, uncompressed, compressed);
+		const int32_t j = Bsp_CompressVis(&bsp_file, uncompressed, compressed);
 
-		dest = map_vis.pointer;
+		byte *dest = map_vis.pointer;
 		map_vis.pointer += j;
 
 		if (map_vis.pointer > map_vis.end) {
@@ -433,8 +448,11 @@ static void CalcPHS(void) {
 		memcpy(dest, compressed, j);
 	}
 
+	Mem_Free(map_vis.uncompressed_phs);
+	map_vis.uncompressed_phs = NULL;
+
 	if (map_vis.portal_clusters) {
-		Com_Print("Average clusters hearable: %i\n", count / map_vis.portal_clusters);
+		Com_Print("Average clusters hearable: %i\n", (int32_t) (count / map_vis.portal_clusters));
 	} else {
 		Com_Print("Average clusters hearable: 0\n");
 	}
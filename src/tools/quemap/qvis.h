@@ -116,6 +116,7 @@ typedef struct map_vis_s {
 
 	size_t uncompressed_size;
 	byte *uncompressed;
+	byte *uncompressed_phs;
 
 	byte *base;
 	byte *pointer;
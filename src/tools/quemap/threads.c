@@ -24,6 +24,7 @@
 
 semaphores_t semaphores;
 thread_work_t thread_work;
+int32_t thread_limit; // if non-zero, the most threads RunThreadsOn may use
 
 /**
  * @brief Initializes the shared semaphores that threads will touch.
@@ -34,8 +35,6 @@ void Sem_Init(void) {
 
 	semaphores.active_portals = SDL_CreateSemaphore(0);
 	semaphores.active_nodes = SDL_CreateSemaphore(0);
-	semaphores.vis_nodes = SDL_CreateSemaphore(0);
-	semaphores.nonvis_nodes = SDL_CreateSemaphore(0);
 	semaphores.active_brushes = SDL_CreateSemaphore(0);
 	semaphores.active_windings = SDL_CreateSemaphore(0);
 	semaphores.removed_points = SDL_CreateSemaphore(0);
@@ -48,27 +47,46 @@ void Sem_Shutdown(void) {
 
 	SDL_DestroySemaphore(semaphores.active_portals);
 	SDL_DestroySemaphore(semaphores.active_nodes);
-	SDL_DestroySemaphore(semaphores.vis_nodes);
-	SDL_DestroySemaphore(semaphores.nonvis_nodes);
 	SDL_DestroySemaphore(semaphores.active_brushes);
 	SDL_DestroySemaphore(semaphores.active_windings);
 	SDL_DestroySemaphore(semaphores.removed_points);
 }
 
+#define THREAD_WORK_CHUNK_DIVISOR 8
+#define THREAD_WORK_CHUNK_MAX 64
+#define THREAD_PROGRESS_INTERVAL 100
+
 /**
- * @brief Return an iteration of work, updating progress when appropriate.
+ * @brief Claims a contiguous chunk of work. Chunks shrink as the remaining
+ * work does, so that threads finish together without contending for every
+ * iteration early on.
+ * @return True if work was claimed, false if the work is done or killed.
  */
-static int32_t GetThreadWork(void) {
+static _Bool GetThreadWork(int32_t *start, int32_t *end) {
+
+	if (!Com_WasInit(QUETOO_MAPTOOL)) { // killed
+		return false;
+	}
 
-	ThreadLock();
+	const int32_t remaining = thread_work.count - g_atomic_int_get(&thread_work.index);
+	const int32_t chunk = Clamp(remaining / (thread_work.workers * THREAD_WORK_CHUNK_DIVISOR), 1, THREAD_WORK_CHUNK_MAX);
 
-	if (thread_work.index == thread_work.count || !Com_WasInit(QUETOO_MAPTOOL)) { // done or killed
-		ThreadUnlock();
-		return -1;
+	*start = g_atomic_int_add(&thread_work.index, chunk);
+	if (*start >= thread_work.count) { // done
+		return false;
 	}
 
-	// update work fraction and output progress if desired
-	const int32_t f = 50 * thread_work.index / thread_work.count;
+	*end = Min(*start + chunk, thread_work.count);
+	return true;
+}
+
+/**
+ * @brief Outputs progress up to the fraction of work completed. Only one
+ * thread, the reporter, may call this.
+ */
+static void ThreadProgress(void) {
+
+	const int32_t f = 50 * g_atomic_int_get(&thread_work.completed) / Max(thread_work.count, 1);
 	if (f != thread_work.fraction) {
 		if (thread_work.progress && !(verbose || debug)) {
 			for (int32_t i = thread_work.fraction; i < f; i++) {
@@ -81,31 +99,48 @@ static int32_t GetThreadWork(void) {
 		}
 		thread_work.fraction = f;
 	}
-
-	// assign the next work iteration
-	const int32_t r = thread_work.index;
-	thread_work.index++;
-
-	ThreadUnlock();
-
-	return r;
 }
 
 // generic function pointer to actual work to be done
 static ThreadWorkFunc WorkFunction;
 
+// signalled by each thread as it finishes, waking the reporter
+static SDL_mutex *progress_lock = NULL;
+static SDL_cond *progress_cond = NULL;
+
 /**
  * @brief Shared work entry point by all threads. Retrieve and perform
  * chunks of work iteratively until work is finished.
  */
 static void ThreadWork(void *p) {
 
-	while (true) {
-		const int32_t work = GetThreadWork();
-		if (work == -1) {
-			break;
+	const int32_t slot = g_atomic_int_add(&thread_work.slots, 1);
+	gint64 busy = 0;
+
+	int32_t start, end;
+	while (GetThreadWork(&start, &end)) {
+		const gint64 time = g_get_monotonic_time();
+
+		for (int32_t i = start; i < end; i++) {
+			WorkFunction(thread_work.order ? thread_work.order[i] : i);
 		}
-		WorkFunction(work);
+
+		busy += g_get_monotonic_time() - time;
+
+		g_atomic_int_add(&thread_work.completed, end - start);
+
+		if (p) { // single-threaded, so report progress inline
+			ThreadProgress();
+		}
+	}
+
+	thread_work.busy[slot] = busy;
+
+	if (progress_cond) {
+		SDL_LockMutex(progress_lock);
+		thread_work.finished++;
+		SDL_CondSignal(progress_cond);
+		SDL_UnlockMutex(progress_lock);
 	}
 }
 
@@ -136,53 +171,136 @@ void ThreadUnlock(void) {
 }
 
 /**
- * @brief
+ * @brief Runs the work on the thread pool, while the calling thread reports
+ * progress. The reporter sleeps until a thread finishes or the progress
+ * interval elapses, so that short passes return as soon as their work does.
  */
 static void RunThreads(void) {
 
 	const uint16_t thread_count = Thread_Count();
 
 	if (thread_count == 0) {
-		ThreadWork(0);
+		thread_work.workers = 1;
+		ThreadWork(&thread_work);
 		return;
 	}
 
+	thread_work.workers = Min(thread_count, MAX_THREADS);
+
+	if (thread_limit) {
+		thread_work.workers = Min(thread_work.workers, thread_limit);
+	}
+
 	assert(!lock);
 	lock = SDL_CreateMutex();
 
-	thread_t *threads[thread_count];
+	progress_lock = SDL_CreateMutex();
+	progress_cond = SDL_CreateCond();
 
-	for (uint16_t i = 0; i < thread_count; i++) {
-		threads[i] = Thread_Create(ThreadWork, NULL);
+	thread_counter_t counter = { 0 };
+
+	for (int32_t i = 0; i < thread_work.workers; i++) {
+		Thread_Submit(ThreadWork, NULL, &counter);
 	}
 
-	for (uint16_t i = 0; i < thread_count; i++) {
-		Thread_Wait(threads[i]);
+	SDL_LockMutex(progress_lock);
+
+	while (thread_work.finished < thread_work.workers) {
+		SDL_CondWaitTimeout(progress_cond, progress_lock, THREAD_PROGRESS_INTERVAL);
+		ThreadProgress();
 	}
 
+	SDL_UnlockMutex(progress_lock);
+
+	Thread_WaitCounter(&counter);
+
+	ThreadProgress();
+
+	SDL_DestroyCond(progress_cond);
+	progress_cond = NULL;
+
+	SDL_DestroyMutex(progress_lock);
+	progress_lock = NULL;
+
 	SDL_DestroyMutex(lock);
 	lock = NULL;
 }
 
+static ThreadCostFunc CostFunction;
+
+/**
+ * @brief Sorts work by descending cost, and then by index for stability.
+ */
+static int32_t RunThreadsOn_Compare(const void *a, const void *b) {
+
+	const int32_t i = *(int32_t *) a, j = *(int32_t *) b;
+	const vec_t ci = CostFunction(i), cj = CostFunction(j);
+
+	if (ci > cj) {
+		return -1;
+	}
+	if (ci < cj) {
+		return 1;
+	}
+
+	return i - j;
+}
+
 /**
  * @brief Entry point for all thread work requests.
  */
 void RunThreadsOn(int32_t work_count, _Bool progress, ThreadWorkFunc func) {
+	RunThreadsOnCost(work_count, progress, func, NULL);
+}
+
+/**
+ * @brief Entry point for thread work requests of uneven cost. Work is run from
+ * the most to the least costly, so that the longest iterations do not trail
+ * at the end of the pass.
+ */
+void RunThreadsOnCost(int32_t work_count, _Bool progress, ThreadWorkFunc func, ThreadCostFunc cost) {
 
 	thread_work.index = 0;
 	thread_work.count = work_count;
+	thread_work.completed = 0;
 	thread_work.fraction = 0;
+	thread_work.order = NULL;
+	thread_work.slots = 0;
+	thread_work.finished = 0;
 	thread_work.progress = progress;
 
+	memset(thread_work.busy, 0, sizeof(thread_work.busy));
+
+	if (cost && work_count > 1) {
+		thread_work.order = Mem_Malloc(work_count * sizeof(int32_t));
+
+		for (int32_t i = 0; i < work_count; i++) {
+			thread_work.order[i] = i;
+		}
+
+		CostFunction = cost;
+		qsort(thread_work.order, work_count, sizeof(int32_t), RunThreadsOn_Compare);
+	}
+
 	WorkFunction = func;
 
-	const time_t start = time(NULL);
+	const gint64 start = g_get_monotonic_time();
 
 	RunThreads();
 
-	const time_t end = time(NULL);
+	const gint64 elapsed = Max(g_get_monotonic_time() - start, (gint64) 1);
+
+	gint64 busy = 0;
+	for (int32_t i = 0; i < thread_work.slots; i++) {
+		busy += thread_work.busy[i];
+		Com_Verbose("Thread %d: %.0f%% utilization\n", i, 100.0 * thread_work.busy[i] / elapsed);
+	}
 
 	if (thread_work.progress) {
-		Com_Print(" (%i seconds)\n", (int32_t) (end - start));
+		Com_Print(" (%i seconds, %.0f%% utilization of %d threads)\n", (int32_t) (elapsed / 1000000),
+		          100.0 * busy / (elapsed * thread_work.workers), thread_work.workers);
 	}
+
+	Mem_Free(thread_work.order);
+	thread_work.order = NULL;
 }